@@ -0,0 +1,154 @@
+/**
+ * @fileOverview
+ * Adversarial line classification benchmark.
+ *
+ * Feeds 1KB to 1MB lines of long identifier runs and unbalanced
+ * parenthesis through the classifier and a full parse, asserting that
+ * throughput stays flat as lines grow. The legacy regex is measured on
+ * the smaller sizes only, since its cost grows quadratically. Long struct
+ * member lines are parsed with their declarations decomposed as well.
+ *
+ * @name classifier.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const classify = require('../lib/classifier').classify;
+const ast_gen = require('../lib/abstractor').ast_gen;
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+/**
+ * Legacy function selector, kept for comparison.
+ */
+const LEGACY_FN = /[aA0-zZ9_\s]+\(.*\)/;
+
+/**
+ * Largest size the legacy regex is measured at.
+ */
+const LEGACY_LIMIT = 16 * 1024;
+
+/**
+ * Minimum throughput of the largest size relative to the smallest.
+ */
+const FLAT_RATIO = 0.5;
+
+const SIZES = [1024, 10 * 1024, 100 * 1024, 1024 * 1024];
+
+const SHAPES = {
+  identifier: (n) => 'a'.repeat(n),
+  open_paren: (n) => 'a'.repeat(n / 2) + '(' + 'b'.repeat(n / 2 - 1),
+  macro_table: (n) => 'X(a_b, 0x1f) '.repeat(Math.ceil(n / 13)).slice(0, n),
+};
+
+/**
+ * Struct member lines, with long runs where a declaration's trailing
+ * bitfield, dimensions or name are looked for.
+ */
+const MEMBERS = {
+  spaced: (n) => `int${' '.repeat(n)}x;`,
+  dims: (n) => `int x${'[1]'.repeat(Math.floor(n / 3))};`,
+  spaced_bits: (n) => `int x :${' '.repeat(n)}y z;`,
+  fn_ptr: (n) => `void (*${' '.repeat(n)}f;`,
+};
+
+/**
+ * Megabytes per second for a number of bytes processed in ms.
+ */
+function mbps(bytes, ms) {
+  return (bytes / (1024 * 1024)) / (ms / 1000);
+}
+
+async function run() {
+  let ok = true;
+  const rows = [];
+
+  for (const shape in SHAPES) {
+    const rates = [];
+
+    for (const size of SIZES) {
+      const ln = SHAPES[shape](size);
+      const iterations = Math.max(1, Math.floor((8 * 1024 * 1024) / size));
+
+      classify(ln);
+      const ms = helper.time(() => classify(ln), iterations);
+      const rate = mbps(size, ms);
+      rates.push(rate);
+
+      let legacy = '-';
+      if (size <= LEGACY_LIMIT) {
+        legacy = fmt(mbps(size, helper.time(() => LEGACY_FN.test(ln), 1)));
+      }
+
+      rows.push([shape, size, fmt(ms, 4), fmt(rate), legacy]);
+    }
+
+    const ratio = rates[rates.length - 1] / rates[0];
+    if (ratio < FLAT_RATIO) {
+      console.error(`${shape}: throughput ratio ${fmt(ratio)} < ${FLAT_RATIO}`);
+      ok = false;
+    }
+  }
+
+  helper.table('classify() per line',
+    ['shape', 'bytes', 'ms', 'MB/s', 'legacy MB/s'], rows);
+
+  // End to end parse of a generated file made of 100KB lines.
+  const parse_rows = [];
+  const parse_rates = [];
+  for (const size of [1024, 100 * 1024]) {
+    const count = Math.max(4, Math.floor((4 * 1024 * 1024) / size));
+    const text = [];
+    for (let i = 0; i < count; i++) {
+      text.push(i % 2 ? SHAPES.identifier(size) : SHAPES.open_paren(size));
+    }
+    const input = text.join('\n');
+
+    const ms = await helper.time_async(() => ast_gen(helper.lines(input)));
+    const rate = mbps(input.length, ms);
+    parse_rates.push(rate);
+    parse_rows.push([size, count, fmt(ms), fmt(rate)]);
+  }
+
+  helper.table('ast_gen() on long lines',
+    ['line bytes', 'lines', 'ms', 'MB/s'], parse_rows);
+
+  if (parse_rates[1] / parse_rates[0] < FLAT_RATIO) {
+    console.error('ast_gen throughput degrades with line length');
+    ok = false;
+  }
+
+  // Struct members, decomposed into declarations.
+  const member_rows = [];
+  for (const shape in MEMBERS) {
+    const rates = [];
+    for (const size of [1024, 100 * 1024]) {
+      const count = Math.max(4, Math.floor((2 * 1024 * 1024) / size));
+      const text = ['struct s {'];
+      for (let i = 0; i < count; i++) {
+        text.push(MEMBERS[shape](size));
+      }
+      text.push('};');
+      const input = text.join('\n');
+
+      const ms = await helper.time_async(() =>
+        ast_gen(helper.lines(input), { decl: true }));
+      const rate = mbps(input.length, ms);
+      rates.push(rate);
+      member_rows.push([shape, size, count, fmt(ms), fmt(rate)]);
+    }
+
+    if (rates[1] / rates[0] < FLAT_RATIO) {
+      console.error(`${shape} members: throughput degrades with line length`);
+      ok = false;
+    }
+  }
+
+  helper.table('ast_gen() on long member lines, with decl',
+    ['shape', 'line bytes', 'lines', 'ms', 'MB/s'], member_rows);
+
+  return ok;
+}
+
+helper.main(module, run);
+module.exports = run;
@@ -0,0 +1,136 @@
+/**
+ * @fileOverview
+ * Event loop delay benchmark.
+ *
+ * Parses a large generated header, already buffered in memory, while a
+ * 1ms interval probes how late the event loop serves it. The default
+ * parse is compared with time sliced ones. Also checks that an
+ * interactive parse started after a background one overtakes it.
+ *
+ * @name eventloop.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const readline = require('readline');
+const Readable = require('stream').Readable;
+const ast_gen = require('../lib/abstractor').ast_gen;
+const Scheduler = require('../lib/scheduler').Scheduler;
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+/**
+ * Copies of the specimen parsed as a single input.
+ */
+const COPIES = 40;
+
+const SLICES = [0, 8, 2];
+
+/**
+ * Size of the in-memory chunks fed to the parser.
+ */
+const CHUNK = 64 * 1024;
+
+/**
+ * Line reader over buffered text, in file sized chunks.
+ */
+function buffered(text) {
+  const chunks = [];
+  for (let i = 0; i < text.length; i += CHUNK) {
+    chunks.push(text.slice(i, i + CHUNK));
+  }
+  return readline.createInterface({
+    input: Readable.from(chunks), terminal: false
+  });
+}
+
+/**
+ * Probes event loop lateness with a 1ms interval.
+ * @return {function} stops the probe, returning the lateness samples
+ */
+function probe() {
+  const lags = [];
+  let last = helper.now();
+
+  const timer = setInterval(() => {
+    const t = helper.now();
+    lags.push(Math.max(0, t - last - 1));
+    last = t;
+  }, 1);
+
+  return () => {
+    clearInterval(timer);
+    return lags.sort((a, b) => a - b);
+  };
+}
+
+function percentile(sorted, p) {
+  if (!sorted.length) {
+    return 0;
+  }
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+async function measure(text, slice) {
+  const stop = probe();
+  const start = helper.now();
+  await ast_gen(buffered(text), slice ? { slice } : {});
+  const ms = helper.now() - start;
+
+  // Let the probe observe the end of a blocking parse.
+  await new Promise((resolve) => setTimeout(resolve, 5));
+  const lags = stop();
+
+  return {
+    ms,
+    p50: percentile(lags, 0.5),
+    p99: percentile(lags, 0.99),
+    max: lags.length ? lags[lags.length - 1] : 0,
+  };
+}
+
+async function overtake(text) {
+  const runner = new Scheduler();
+  const order = [];
+
+  const background = ast_gen(buffered(text),
+    { slice: 2, priority: 'background', scheduler: runner })
+    .then(() => order.push('background'));
+  const interactive = ast_gen(buffered(text),
+    { slice: 2, priority: 'interactive', scheduler: runner })
+    .then(() => order.push('interactive'));
+
+  await Promise.all([background, interactive]);
+  return order;
+}
+
+async function run() {
+  const text = fs.readFileSync(SPECIMEN, 'utf8').repeat(COPIES);
+  const results = {};
+
+  // Warm up the parser before measuring.
+  await ast_gen(buffered(text));
+
+  for (const slice of SLICES) {
+    results[slice] = await measure(text, slice);
+  }
+  const order = await overtake(text);
+
+  helper.table(`event loop delay, ${path.basename(SPECIMEN)} x${COPIES}`,
+    ['slice ms', 'parse ms', 'p50 ms', 'p99 ms', 'max ms'],
+    SLICES.map((s) => [s || 'none', fmt(results[s].ms), fmt(results[s].p50),
+      fmt(results[s].p99), fmt(results[s].max)]));
+
+  console.log(`\ncompletion order: ${order.join(', ')}`);
+
+  const blocking = results[0];
+  const sliced = results[SLICES[SLICES.length - 1]];
+  return sliced.max < blocking.max / 2 && order[0] == 'interactive';
+}
+
+helper.main(module, run);
+module.exports = run;
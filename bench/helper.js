@@ -0,0 +1,156 @@
+/**
+ * @fileOverview
+ * Benchmark helper funcs
+ * Shared timing, heap, input and reporting support for the bench suite.
+ *
+ * @name helper.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const v8 = require('v8');
+const Readable = require('stream').Readable;
+const readline = require('readline');
+
+const STRINGS = ['string', 'sliced string', 'concatenated string'];
+
+/**
+ * Creates a line reader over in-memory text, suitable for `ast_gen`.
+ *
+ * @param {string} text source input
+ * @return {object} readline interface
+ */
+function lines(text) {
+  return readline.createInterface({
+    input: Readable.from([text || '']), terminal: false
+  });
+}
+
+/**
+ * High resolution wall clock in milliseconds.
+ *
+ * @return {number}
+ */
+function now() {
+  return Number(process.hrtime.bigint()) / 1e6;
+}
+
+/**
+ * Times a synchronous function over a number of iterations.
+ *
+ * @param {function} fn work to be measured
+ * @param {number} iterations repetitions
+ * @return {number} milliseconds per iteration
+ */
+function time(fn, iterations = 1) {
+  const start = now();
+  for (let i = 0; i < iterations; i++) {
+    fn();
+  }
+  return (now() - start) / iterations;
+}
+
+/**
+ * Times an asynchronous function over a number of iterations.
+ *
+ * @param {function} fn async work to be measured
+ * @param {number} iterations repetitions
+ * @return {number} milliseconds per iteration
+ */
+async function time_async(fn, iterations = 1) {
+  const start = now();
+  for (let i = 0; i < iterations; i++) {
+    await fn();
+  }
+  return (now() - start) / iterations;
+}
+
+/**
+ * Prints an aligned result table.
+ *
+ * @param {string} title of the table
+ * @param {array} header column names
+ * @param {array} rows array of column value arrays
+ */
+function table(title, header, rows) {
+  const all = [header, ...rows].map((r) => r.map(String));
+  const widths = header.map((_, i) =>
+    Math.max(...all.map((r) => r[i].length)));
+
+  console.log(`\n${title}`);
+  all.forEach((r, n) => {
+    console.log('  ' + r.map((c, i) => c.padStart(widths[i])).join('  '));
+    if (n == 0) {
+      console.log('  ' + widths.map((w) => '-'.repeat(w)).join('  '));
+    }
+  });
+}
+
+/**
+ * Bytes of the heap and of its strings, from a snapshot, which collects
+ * garbage first.
+ *
+ * @param {string|optional} dir directory the snapshot is written to
+ * @return {object} { total, strings }
+ */
+function heap(dir = os.tmpdir()) {
+  const file = v8.writeHeapSnapshot(
+    path.join(dir, `c-ast-${process.pid}.heapsnapshot`));
+  const snap = JSON.parse(fs.readFileSync(file, 'utf8'));
+  fs.unlinkSync(file);
+
+  const fields = snap.snapshot.meta.node_fields;
+  const width = fields.length;
+  const TYPE = fields.indexOf('type');
+  const SIZE = fields.indexOf('self_size');
+  const names = snap.snapshot.meta.node_types[0];
+  const nodes = snap.nodes;
+  let total = 0;
+  let strings = 0;
+
+  for (let i = 0; i < nodes.length; i += width) {
+    total += nodes[i + SIZE];
+    if (STRINGS.indexOf(names[nodes[i + TYPE]]) >= 0) {
+      strings += nodes[i + SIZE];
+    }
+  }
+  return { total, strings };
+}
+
+/**
+ * Formats a number with fixed decimals.
+ */
+function fmt(n, digits = 2) {
+  return Number(n).toFixed(digits);
+}
+
+/**
+ * Runs a bench module's `run` export when invoked directly.
+ *
+ * @param {object} mod calling module
+ * @param {function} run bench entry, resolving to true on success
+ */
+function main(mod, run) {
+  if (require.main === mod) {
+    run().then((ok) => {
+      process.exitCode = ok === false ? 1 : 0;
+    }).catch((err) => {
+      console.error(err);
+      process.exitCode = 1;
+    });
+  }
+}
+
+module.exports = {
+  lines,
+  now,
+  time,
+  time_async,
+  table,
+  heap,
+  fmt,
+  main,
+};
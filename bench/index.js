@@ -0,0 +1,36 @@
+/**
+ * @fileOverview
+ * Runs every `*.bench.js` suite in sequence.
+ * Exits non-zero when any suite reports a failed threshold.
+ *
+ * @name index.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+
+async function run() {
+  const only = process.argv.slice(2);
+  const suites = fs.readdirSync(__dirname)
+    .filter((f) => f.endsWith('.bench.js'))
+    .filter((f) => !only.length || only.some((o) => f.indexOf(o) >= 0))
+    .sort();
+
+  let ok = true;
+  for (const suite of suites) {
+    console.log(`\n== ${suite}`);
+    const result = await require(path.join(__dirname, suite))();
+    if (result === false) {
+      console.error(`!! ${suite} failed its threshold`);
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+run().then((ok) => {
+  process.exitCode = ok ? 0 : 1;
+});
@@ -0,0 +1,204 @@
+/**
+ * @fileOverview
+ * Cross-file interning benchmark.
+ *
+ * Writes a batch of related generated headers, sharing a license banner,
+ * include guard layout and common declarations along with lines of their
+ * own, then parses them from disk keeping every AST alive. Heap
+ * snapshots taken before and after each batch give the string and total
+ * bytes the batch retains, with and without a shared intern pool. Fails
+ * when interning does not save a fixed share of the string bytes, or
+ * when releasing the batch leaves strings pooled.
+ *
+ * Also interns lines sliced out of large parent strings, as a stream
+ * reader hands them out, and fails when the lease keeps the parents
+ * alive once they are dropped.
+ *
+ * @name intern.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const ast_from_file = require('../lib/abstractor').ast_from_file;
+const InternPool = require('../lib/intern').InternPool;
+const samples = require('../tests/samples');
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+/**
+ * Headers in the batch.
+ */
+const FILES = 300;
+
+/**
+ * Lines of the specimen's license banner heading every header.
+ */
+const BANNER = 30;
+
+/**
+ * Minimum share of the string bytes saved by interning.
+ */
+const MIN_SAVING = 0.4;
+
+/**
+ * Parent strings lines are sliced out of, and their size.
+ */
+const PARENTS = 64;
+const PARENT_BYTES = 256 * 1024;
+
+/**
+ * Maximum share of the parents' bytes retained by their pooled lines.
+ */
+const MAX_PARENT_SHARE = 0.01;
+
+/**
+ * Writes the batch: a common banner and a few shared samples, along with
+ * declarations of each header's own.
+ *
+ * @param {string} dir destination
+ * @return {array} header paths
+ */
+function corpus(dir) {
+  const banner = fs.readFileSync(SPECIMEN, 'utf8').split('\n')
+    .slice(0, BANNER).join('\n');
+  const shared = Object.values(samples);
+  const files = [];
+
+  for (let i = 0; i < FILES; i++) {
+    const guard = `SDK_MODULE_${i}_H`;
+    let text = `${banner}\n#ifndef ${guard}\n#define ${guard}\n\n`;
+    for (let k = 0; k < 3; k++) {
+      text += shared[(i * 3 + k) % shared.length] + '\n';
+    }
+    for (let k = 0; k < 20; k++) {
+      text += `/* Returns the ${k}th setting of module ${i} */\n` +
+        `SDK_API int sdk_module_${i}_get_${k}(struct sdk_context *ctx);\n\n`;
+    }
+
+    const file = path.join(dir, `sdk_module_${i}.h`);
+    fs.writeFileSync(file, text + `#endif /* ${guard} */\n`);
+    files.push(file);
+  }
+  return files;
+}
+
+/**
+ * Bytes retained by the batch parsed with the given options. ASTs are
+ * only reachable from within, so that none outlives the measure.
+ *
+ * @param {string} dir scratch directory
+ * @param {array} files header paths
+ * @param {object} opts generation options
+ * @param {function|optional} done given the ASTs once measured
+ * @return {object} { total, strings }
+ */
+async function retained(dir, files, opts, done = () => {}) {
+  const base = helper.heap(dir);
+  const asts = [];
+  for (const file of files) {
+    asts.push(await ast_from_file(file, opts));
+  }
+
+  const held = helper.heap(dir);
+  done(asts);
+  return {
+    total: held.total - base.total,
+    strings: held.strings - base.strings,
+  };
+}
+
+/**
+ * Interns the first line of each of a number of large parents, which go
+ * out of scope on return.
+ *
+ * @param {Lease} lease
+ * @return {number} bytes of the parents
+ */
+function intern_sliced(lease) {
+  let parents = 0;
+  for (let i = 0; i < PARENTS; i++) {
+    const parent = `int parent_line_${i};\n` + 'x'.repeat(PARENT_BYTES);
+    parents += parent.length;
+    lease.intern(parent.slice(0, parent.indexOf('\n')));
+  }
+  return parents;
+}
+
+/**
+ * String bytes a lease retains for lines sliced out of large parents,
+ * once the parents are dropped.
+ *
+ * @param {string} dir scratch directory
+ * @return {object} { parents, retained } bytes
+ */
+function parents_retained(dir) {
+  const lease = new InternPool().lease();
+  const base = helper.heap(dir);
+  const parents = intern_sliced(lease);
+  const held = helper.heap(dir);
+  if (lease.held.length != PARENTS) {
+    throw new Error('lease lost its lines');
+  }
+  return { parents, retained: held.strings - base.strings };
+}
+
+async function run() {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'c-ast-intern-'));
+
+  try {
+    const files = corpus(dir);
+
+    // Warm up the parser before measuring.
+    await retained(dir, files.slice(0, 10), {});
+
+    const plain = await retained(dir, files, {});
+
+    const pool = new InternPool();
+    let stats;
+    const interned = await retained(dir, files, { intern: pool }, (asts) => {
+      stats = pool.stats();
+      for (const ast of asts) {
+        pool.release(ast);
+      }
+    });
+
+    const kb = (n) => fmt(n / 1024, 0);
+    const saving = 1 - interned.strings / plain.strings;
+    helper.table(`batch of ${FILES} headers, ${stats.size} distinct ` +
+      `strings pooled, ${stats.hits} shared`,
+    ['mode', 'string KiB', 'heap KiB', 'strings saved', 'heap saved'],
+    [
+      ['plain', kb(plain.strings), kb(plain.total), '-', '-'],
+      ['interned', kb(interned.strings), kb(interned.total),
+        fmt(saving * 100, 1) + '%',
+        fmt((1 - interned.total / plain.total) * 100, 1) + '%'],
+    ]);
+
+    const sliced = parents_retained(dir);
+    const share = sliced.retained / sliced.parents;
+    helper.table(`${PARENTS} lines sliced out of ${kb(PARENT_BYTES)} KiB ` +
+      'parents, once dropped',
+    ['parent KiB', 'retained KiB', 'share'],
+    [[kb(sliced.parents), kb(sliced.retained), fmt(share * 100, 2) + '%']]);
+
+    if (pool.size) {
+      console.error(`!! ${pool.size} strings left pooled after release`);
+      return false;
+    }
+    if (share > MAX_PARENT_SHARE) {
+      console.error('!! pooled lines keep their parent strings alive');
+      return false;
+    }
+    return saving >= MIN_SAVING;
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+}
+
+helper.main(module, run);
+module.exports = run;
@@ -0,0 +1,70 @@
+/**
+ * @fileOverview
+ * Retained memory benchmark.
+ *
+ * Parses a large generated header under several extraction profiles and
+ * reports the estimated bytes retained per container. Fails when the
+ * full tree grows beyond a fixed multiple of its source size.
+ *
+ * @name memory.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const memory = require('../lib/memory');
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+/**
+ * Copies of the specimen parsed as a single input.
+ */
+const COPIES = 20;
+
+/**
+ * Maximum estimated AST bytes per source byte for the full profile.
+ */
+const MAX_RATIO = 8;
+
+const PROFILES = {
+  full: { memory: true },
+  'no index': { index: false, memory: true },
+  'comments,defs': {
+    only: 'comments,defs', members: false, index: false, memory: true
+  },
+};
+
+async function run() {
+  const text = fs.readFileSync(SPECIMEN, 'utf8').repeat(COPIES);
+  const bytes = Buffer.byteLength(text);
+  const reports = {};
+
+  for (const name in PROFILES) {
+    const ast = await ast_gen(helper.lines(text), PROFILES[name]);
+    reports[name] = ast.memoryStats();
+  }
+
+  const containers = Object.keys(reports.full.containers);
+  const kb = (n) => fmt(n / 1024, 1);
+
+  helper.table(`estimated KB retained, ${path.basename(SPECIMEN)} x${COPIES}`,
+    ['container', ...Object.keys(PROFILES)],
+    [
+      ...containers.map((c) => [c,
+        ...Object.values(reports).map((r) => kb(r.containers[c].bytes))]),
+      ['total', ...Object.values(reports).map((r) => kb(r.total))],
+      ['x source', ...Object.values(reports).map((r) => fmt(r.total / bytes))],
+      ['peak heap', ...Object.values(reports).map((r) => kb(r.peak.heap))],
+    ]);
+
+  console.log('\n' + memory.format(reports.full));
+
+  return reports.full.total / bytes < MAX_RATIO;
+}
+
+helper.main(module, run);
+module.exports = run;
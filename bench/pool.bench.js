@@ -0,0 +1,108 @@
+/**
+ * @fileOverview
+ * Repeated parse server workload.
+ *
+ * Parses the same header over and over, as a long running service would,
+ * with and without a NodePool. Reports node allocations, along with the
+ * assocs and data objects every node is given, garbage collections and GC
+ * pause time for each mode.
+ *
+ * @name pool.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const PerformanceObserver = require('perf_hooks').PerformanceObserver;
+
+const ast_gen = require('../lib/abstractor').ast_gen;
+const NodePool = require('../lib/pool').NodePool;
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '../specimen/sample.h');
+const ROUNDS = parseInt(process.env.ROUNDS || 200);
+
+/**
+ * Objects allocated per new node: the node, its assocs and its data.
+ * Recycled nodes are given fresh assocs and data.
+ */
+const NODE_OBJECTS = 3;
+const RECYCLED_OBJECTS = 2;
+
+/**
+ * Collects GC counts and pause durations while active.
+ */
+function gc_monitor() {
+  const stats = { count: 0, ms: 0 };
+  const obs = new PerformanceObserver((list) => {
+    for (const entry of list.getEntries()) {
+      stats.count++;
+      stats.ms += entry.duration;
+    }
+  });
+  obs.observe({ entryTypes: ['gc'] });
+  stats.stop = () => obs.disconnect();
+  return stats;
+}
+
+/**
+ * Counts every node reachable from an AST.
+ */
+function count_nodes(ast) {
+  let n = 0;
+  for (const type of ['comments', 'code', 'defs', 'char']) {
+    for (const id in ast[type]) {
+      n++;
+      const inner = ast[type][id].inner;
+      n += inner ? inner.filter((i) => i.type == 'members').length : 0;
+    }
+  }
+  return n;
+}
+
+async function workload(text, pool) {
+  let nodes = 0;
+  const gc = gc_monitor();
+  const ms = await helper.time_async(async () => {
+    const ast = await ast_gen(helper.lines(text), { pool });
+    nodes += count_nodes(ast);
+    if (pool) {
+      pool.release(ast);
+    }
+  }, ROUNDS);
+
+  // Let the observer flush pending entries.
+  await new Promise((resolve) => setTimeout(resolve, 50));
+  gc.stop();
+
+  const stats = pool ? pool.stats() : { created: nodes, reused: 0 };
+  const allocated = stats.created;
+  const objects = stats.created * NODE_OBJECTS +
+    stats.reused * RECYCLED_OBJECTS;
+  return { ms, nodes, allocated, objects, gc };
+}
+
+async function run() {
+  const text = fs.readFileSync(SPECIMEN, 'utf8');
+
+  // Warm up the parser before measuring.
+  await workload(text, null);
+
+  const plain = await workload(text, null);
+  const pooled = await workload(text, new NodePool());
+
+  const row = (name, r) => [name, ROUNDS, r.nodes, r.allocated, r.objects,
+    r.gc.count, fmt(r.gc.ms), fmt(r.ms)];
+
+  helper.table(`repeated parse of ${path.basename(SPECIMEN)}`,
+    ['mode', 'rounds', 'nodes', 'new nodes', 'objects', 'gc runs', 'gc ms',
+      'ms/parse'],
+    [row('object', plain), row('pooled', pooled)]);
+
+  return pooled.objects < plain.objects;
+}
+
+helper.main(module, run);
+module.exports = run;
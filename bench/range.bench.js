@@ -0,0 +1,83 @@
+/**
+ * @fileOverview
+ * Range parsing benchmark.
+ *
+ * Parses narrow line ranges of a large generated header, from the top
+ * of the file and from its checkpoints, against a full parse. Fails
+ * when a checkpointed range does not cost a small fraction of the
+ * full parse.
+ *
+ * @name range.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const ast_from_file = require('../lib/abstractor').ast_from_file;
+const checkpoint = require('../lib/checkpoint');
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+/**
+ * Copies of the specimen parsed as a single input.
+ */
+const COPIES = 100;
+
+/**
+ * Lines in between checkpoints, and lines per requested range.
+ */
+const EVERY = 512;
+const WIDTH = 50;
+
+/**
+ * Maximum cost of a checkpointed range, as a share of the full parse.
+ */
+const MAX_SHARE = 0.1;
+
+async function run() {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'c-ast-range-'));
+  const file = path.join(dir, 'sample.h');
+  fs.writeFileSync(file, fs.readFileSync(SPECIMEN, 'utf8').repeat(COPIES));
+
+  try {
+    // Warm up the parser before measuring.
+    await ast_from_file(file);
+    const full = await helper.time_async(() => ast_from_file(file), 3);
+    const build = helper.time(() => checkpoint.build(file,
+      { checkpoints: EVERY }));
+    const lines = checkpoint.load(file).lines;
+    const sidecar = fs.statSync(checkpoint.sidecar_path(file)).size;
+
+    const rows = [];
+    let worst = 0;
+    for (const at of [0.1, 0.5, 0.9]) {
+      const start = Math.floor(lines * at);
+      const end = start + WIDTH;
+
+      const resumed = helper.time(() =>
+        checkpoint.range(file, start, end), 5);
+      const top = helper.time(() =>
+        checkpoint.range(file, start, end, { sidecar: '/nonexistent' }), 3);
+
+      worst = Math.max(worst, resumed / full);
+      rows.push([`${start},${end}`, fmt(top), fmt(resumed),
+        fmt(resumed / full * 100, 1) + '%']);
+    }
+
+    helper.table(`range parsing, ${path.basename(SPECIMEN)} x${COPIES} ` +
+      `(${lines} lines, full parse ${fmt(full)} ms, ` +
+      `checkpoints ${fmt(build)} ms, sidecar ${sidecar} bytes)`,
+      ['range', 'from top ms', 'checkpointed ms', 'of full'], rows);
+
+    return worst < MAX_SHARE;
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+}
+
+helper.main(module, run);
+module.exports = run;
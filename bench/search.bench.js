@@ -0,0 +1,96 @@
+/**
+ * @fileOverview
+ * Comment search benchmark.
+ *
+ * Searches the comments of a large generated header for a few
+ * substrings, through the trigram index and by scanning every comment
+ * node, along with the cost of building the index during the parse.
+ * Fails when indexed searches are not several times faster than scans.
+ *
+ * @name search.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const ast_from_text = require('../lib/abstractor').ast_from_text;
+const C = require('../lib/constants');
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+/**
+ * Copies of the specimen parsed as a single input.
+ */
+const COPIES = 50;
+
+/**
+ * Searches timed per query.
+ */
+const ROUNDS = 20;
+
+const QUERIES = ['nk_window', 'Returns', 'font handle', '@deprecated'];
+
+/**
+ * Minimum speedup of an indexed search over a scan, overall.
+ */
+const MIN_SPEEDUP = 5;
+
+/**
+ * Comment nodes holding a substring, by scanning every comment.
+ */
+function scan(ast, query) {
+  const found = [];
+  for (const id in ast[C.COMM]) {
+    const node = ast[C.COMM][id];
+    for (const lno in node.data) {
+      if (node.data[lno].indexOf(query) >= 0) {
+        found.push(node);
+        break;
+      }
+    }
+  }
+  return found;
+}
+
+async function run() {
+  const text = fs.readFileSync(SPECIMEN, 'utf8').repeat(COPIES);
+
+  // Warm up the parser before measuring.
+  await ast_from_text(text);
+  const plain = await helper.time_async(() => ast_from_text(text), 2);
+  let ast;
+  const indexed = await helper.time_async(async () => {
+    ast = await ast_from_text(text, { search: true });
+  }, 2);
+
+  const rows = [];
+  let scanned = 0;
+  let searched = 0;
+  for (const query of QUERIES) {
+    const found = ast.searchComments(query).length;
+    if (found != scan(ast, query).length) {
+      console.error(`!! ${query}: index and scan disagree`);
+      return false;
+    }
+
+    const slow = helper.time(() => scan(ast, query), ROUNDS);
+    const fast = helper.time(() => ast.searchComments(query), ROUNDS);
+    scanned += slow;
+    searched += fast;
+    rows.push([query, found, fmt(slow, 3), fmt(fast, 3),
+      fmt(slow / fast, 1) + 'x']);
+  }
+
+  helper.table(`comment search, ${path.basename(SPECIMEN)} x${COPIES} ` +
+    `(${ast.keys(C.COMM).length} comments, ${ast.search.grams.size} ` +
+    `trigrams, parse ${fmt(plain)} ms, with index ${fmt(indexed)} ms)`,
+  ['query', 'found', 'scan ms', 'indexed ms', 'speedup'], rows);
+
+  return scanned / searched >= MIN_SPEEDUP;
+}
+
+helper.main(module, run);
+module.exports = run;
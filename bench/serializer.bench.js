@@ -0,0 +1,156 @@
+/**
+ * @fileOverview
+ * AST serialization benchmark.
+ *
+ * Publishes the AST of a large generated header as a snapshot, then
+ * repeatedly edits a single node and serializes the new version, pretty
+ * printed and compact. Each version is also serialized by JSON.stringify
+ * from a plain copy of its data, checking both produce the same bytes.
+ * Fails when snapshot serialization is not faster in either mode, or
+ * when the fragments it keeps outlive the next serializations.
+ *
+ * @name serializer.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const ast_from_text = require('../lib/abstractor').ast_from_text;
+const SnapshotStore = require('../lib/snapshot').SnapshotStore;
+const C = require('../lib/constants');
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+/**
+ * Copies of the specimen parsed as a single input.
+ */
+const COPIES = 20;
+
+/**
+ * Versions serialized per mode.
+ */
+const ROUNDS = 10;
+
+/**
+ * Minimum speedup over JSON.stringify, in each mode.
+ */
+const MIN_SPEEDUP = 1.2;
+
+/**
+ * Minimum share of the serialized bytes released once other snapshots
+ * have been serialized twice in each mode.
+ */
+const MIN_RELEASED = 0.5;
+
+/**
+ * Data of a snapshot as plain objects, as a generated AST is written.
+ */
+function plain(snapshot) {
+  const nodes = {};
+  for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR]) {
+    nodes[type] = {};
+    for (const id of snapshot.keys(type)) {
+      nodes[type][id] = snapshot.nodes[type].get(id);
+    }
+  }
+
+  const index = {};
+  const keys = Array.from(snapshot.index.keys());
+  for (const id of keys.sort((a, b) => parseFloat(a) - parseFloat(b))) {
+    index[id] = snapshot.index.get(id);
+  }
+
+  return snapshot.types.length ?
+    { nodes, types: snapshot.types, index } : { nodes, index };
+}
+
+/**
+ * Next version, with a line of a code node changed.
+ */
+function edit(store, ids, round) {
+  const id = ids[round * 37 % ids.length];
+  return store.update((snapshot) => {
+    const node = snapshot.node(id);
+    const copy = Object.assign(Object.create(Object.getPrototypeOf(node)), node);
+    copy.data = Object.assign({}, node.data);
+    const lno = Object.keys(copy.data)[0];
+    copy.data[lno] = `${copy.data[lno]} /* ${round} */`;
+    return snapshot.set(C.CODE, id, copy);
+  });
+}
+
+async function run() {
+  const ast = await ast_from_text(
+    fs.readFileSync(SPECIMEN, 'utf8').repeat(COPIES));
+  const store = new SnapshotStore();
+  store.publish(ast);
+  const ids = store.current.keys(C.CODE);
+
+  const rows = [];
+  let written = 0;
+  let worst = Infinity;
+  let round = 0;
+  for (const compact of [false, true]) {
+    const stringify = (data) => compact ? JSON.stringify(data) :
+      JSON.stringify(data, null, '    ');
+
+    // First write of every node, not timed
+    const bytes = store.current.json({ compact }).length;
+    written += bytes;
+
+    let slow = 0;
+    let fast = 0;
+    for (let i = 0; i < ROUNDS; i++) {
+      const snapshot = edit(store, ids, round++);
+      const data = plain(snapshot);
+
+      let expected;
+      let out;
+      slow += helper.time(() => {
+        expected = stringify(data);
+      });
+      fast += helper.time(() => {
+        out = snapshot.json({ compact });
+      });
+
+      if (out !== expected) {
+        console.error(`!! ${compact ? 'compact' : 'pretty'} output differs`);
+        return false;
+      }
+    }
+
+    worst = Math.min(worst, slow / fast);
+    rows.push([compact ? 'compact' : 'pretty', (bytes / 1024).toFixed(0),
+      fmt(slow / ROUNDS), fmt(fast / ROUNDS), fmt(slow / fast) + 'x']);
+  }
+
+  helper.table(`snapshot json after one edit, ${path.basename(SPECIMEN)} ` +
+    `x${COPIES} (${ast.source.length} lines)`,
+  ['mode', 'KiB', 'stringify ms', 'snapshot ms', 'speedup'], rows);
+
+  // Fragments are kept for the latest two serializations in each mode,
+  // so serializing another snapshot twice lets go of the store's
+  const held = helper.heap();
+  const other = new SnapshotStore().publish(await ast_from_text('int x;\n'));
+  for (const compact of [false, true]) {
+    other.json({ compact });
+    other.json({ compact });
+  }
+  const released = (held.strings - helper.heap().strings) / written;
+
+  helper.table('fragments released by serializing another snapshot',
+    ['serialized KiB', 'released'],
+    [[(written / 1024).toFixed(0), fmt(released * 100, 1) + '%']]);
+
+  if (released < MIN_RELEASED) {
+    console.error('!! fragments outlive later serializations');
+    return false;
+  }
+  return worst >= MIN_SPEEDUP;
+}
+
+helper.main(module, run);
+module.exports = run;
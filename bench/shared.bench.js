@@ -0,0 +1,102 @@
+/**
+ * @fileOverview
+ * Shared AST handoff benchmark.
+ *
+ * Hands ASTs of growing size over to a worker thread, either cloned
+ * through `postMessage` or laid out in shared memory, timing each round
+ * trip until the worker has a readable AST. Fails when the shared
+ * handoff of the largest AST does not cost a small fraction of cloning
+ * it.
+ *
+ * @name shared.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const Worker = require('worker_threads').Worker;
+const ast_from_text = require('../lib/abstractor').ast_from_text;
+const shared = require('../lib/shared');
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+/**
+ * Copies of the specimen parsed for each AST size.
+ */
+const SIZES = [1, 10, 50];
+
+/**
+ * Round trips measured per handoff.
+ */
+const ROUNDS = 5;
+
+/**
+ * Maximum cost of a shared handoff, as a share of a cloned one.
+ */
+const MAX_SHARE = 0.1;
+
+/**
+ * Worker acknowledging each AST once readable.
+ */
+const WORKER = `
+  const { parentPort } = require('worker_threads');
+  const { SharedAST } = require(${JSON.stringify(require.resolve('../lib/shared'))});
+  parentPort.on('message', (msg) => {
+    const ast = msg instanceof SharedArrayBuffer ? new SharedAST(msg) : msg;
+    parentPort.postMessage(ast.source ? ast.source.length : ast.lines);
+  });
+`;
+
+/**
+ * Times round trips of a message to the worker.
+ */
+async function handoff(worker, msg) {
+  const once = () => new Promise((resolve) => {
+    worker.once('message', resolve);
+    worker.postMessage(msg);
+  });
+
+  await once();
+  return helper.time_async(once, ROUNDS);
+}
+
+async function run() {
+  const text = fs.readFileSync(SPECIMEN, 'utf8');
+  const worker = new Worker(WORKER, { eval: true });
+  const rows = [];
+  let share = 0;
+
+  try {
+    for (const copies of SIZES) {
+      const ast = await ast_from_text(text.repeat(copies));
+      const tree = JSON.parse(ast.json());
+      tree.source = ast.source;
+
+      let sab;
+      const exported = helper.time(() => {
+        sab = shared.share(ast);
+      });
+
+      const cloned = await handoff(worker, tree);
+      const handed = await handoff(worker, sab);
+
+      share = handed / cloned;
+      rows.push([`x${copies}`, ast.source.length, fmt(exported),
+        (sab.byteLength / 1024).toFixed(0), fmt(cloned), fmt(handed)]);
+    }
+  } finally {
+    await worker.terminate();
+  }
+
+  helper.table(`worker handoff, ${path.basename(SPECIMEN)}`,
+    ['input', 'lines', 'share ms', 'shared KiB', 'clone ms', 'shared ms'],
+    rows);
+
+  return share < MAX_SHARE;
+}
+
+helper.main(module, run);
+module.exports = run;
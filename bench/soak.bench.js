@@ -0,0 +1,241 @@
+/**
+ * @fileOverview
+ * Soak benchmark for long running embedders.
+ *
+ * Generates, serializes and annotates a varied corpus in a loop for a
+ * set duration, taking heap snapshots at intervals. Retained objects are
+ * tallied by constructor from each snapshot, so that growth points at
+ * what is leaking. Fails when the retained heap, the count of any
+ * constructor or the active handle count keeps growing along with the
+ * rounds run.
+ *
+ * The duration is set in seconds with SOAK_SECONDS, and the number of
+ * snapshots taken with SOAK_SNAPSHOTS.
+ *
+ * @name soak.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const v8 = require('v8');
+const abstractor = require('../lib/abstractor');
+const annotate_file = require('../lib/annotator').annotate_file;
+const samples = require('../tests/samples');
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const SPECIMEN = path.join(__dirname, '..', 'specimen', 'sample.h');
+
+const SECONDS = parseFloat(process.env.SOAK_SECONDS || 10);
+const SNAPSHOTS = Math.max(parseInt(process.env.SOAK_SNAPSHOTS || 4), 2);
+
+/**
+ * Retained heap growth tolerated in between the first and last snapshot.
+ */
+const MAX_GROWTH = 1024 * 1024;
+
+/**
+ * Active handle growth tolerated over the run.
+ */
+const MAX_HANDLES = 0;
+
+/**
+ * Constructors listed in the report.
+ */
+const TOP = 8;
+
+/**
+ * Snapshot node types tallied; the rest are internals of V8.
+ */
+const TALLIED = ['object', 'closure', 'array', 'native', 'regexp'];
+
+/**
+ * Writes the corpus: the specimen, slices of it cut at arbitrary lines,
+ * and each test sample.
+ */
+function corpus(dir) {
+  const specimen = fs.readFileSync(SPECIMEN, 'utf8');
+  const lines = specimen.split('\n');
+  const inputs = { 'specimen.h': specimen };
+
+  for (let i = 1; i <= 4; i++) {
+    const from = Math.floor(lines.length * i / 7);
+    inputs[`slice_${i}.h`] = lines.slice(from, from + 150 * i).join('\n');
+  }
+
+  for (const name in samples) {
+    if (typeof samples[name] == 'string') {
+      inputs[`${name.toLowerCase()}.h`] = samples[name];
+    }
+  }
+
+  return Object.keys(inputs).map((name) => {
+    const file = path.join(dir, name);
+    fs.writeFileSync(file, inputs[name]);
+    return { file, text: inputs[name] };
+  });
+}
+
+/**
+ * Generates, serializes and annotates every input once, alternating
+ * generation options between rounds.
+ */
+async function round(inputs, n) {
+  const opts = [{}, { preprocess: true }, { slice: 2 }][n % 3];
+
+  for (const input of inputs) {
+    const ast = await abstractor.ast_gen(helper.lines(input.text), opts);
+    ast.json();
+    await annotate_file(input.file, { colorize: n % 2 == 1 });
+  }
+}
+
+/**
+ * Writes a heap snapshot, running a full garbage collection first.
+ *
+ * @param {string} dir snapshot directory
+ * @param {number} n snapshot number
+ * @return {string} snapshot file
+ */
+function snapshot(dir, n) {
+  return v8.writeHeapSnapshot(path.join(dir, `${n}.heapsnapshot`));
+}
+
+/**
+ * Tallies the objects retained in a snapshot by constructor.
+ *
+ * @param {string} file heap snapshot
+ * @return {object} { bytes, types: Map of name => { count, bytes } }
+ */
+function tally(file) {
+  const snap = JSON.parse(fs.readFileSync(file, 'utf8'));
+  const meta = snap.snapshot.meta;
+  const fields = meta.node_fields;
+  const width = fields.length;
+  const TYPE = fields.indexOf('type');
+  const NAME = fields.indexOf('name');
+  const SIZE = fields.indexOf('self_size');
+  const names = meta.node_types[0];
+  const nodes = snap.nodes;
+  const types = new Map();
+  let bytes = 0;
+
+  for (let i = 0; i < nodes.length; i += width) {
+    const size = nodes[i + SIZE];
+    const type = names[nodes[i + TYPE]];
+    bytes += size;
+
+    if (TALLIED.indexOf(type) < 0) {
+      continue;
+    }
+
+    const name = `${snap.strings[nodes[i + NAME]]}` +
+      (type == 'closure' ? '()' : type == 'object' ? '' : ` (${type})`);
+    const entry = types.get(name) || { count: 0, bytes: 0 };
+    entry.count++;
+    entry.bytes += size;
+    types.set(name, entry);
+  }
+
+  return { bytes, types };
+}
+
+function handles() {
+  return process._getActiveHandles().length;
+}
+
+/**
+ * Constructors by count growth in between two snapshots.
+ */
+function growth(first, last) {
+  const grown = [];
+  for (const [name, entry] of last.types) {
+    const before = first.types.get(name) || { count: 0, bytes: 0 };
+    if (entry.count > before.count) {
+      grown.push({
+        name,
+        count: entry.count - before.count,
+        bytes: entry.bytes - before.bytes,
+      });
+    }
+  }
+  return grown.sort((a, b) => b.count - a.count);
+}
+
+async function run() {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'c-ast-soak-'));
+  const inputs = corpus(dir);
+  const log = console.log;
+  const marks = [];
+  const files = [];
+  let first;
+  let last;
+  let rounds = 0;
+
+  try {
+    // Annotations print through console.log
+    console.log = () => {};
+
+    // Warm up lazily built module state before the first snapshot
+    for (; rounds < 3; rounds++) {
+      await round(inputs, rounds);
+    }
+
+    const interval = SECONDS * 1000 / (SNAPSHOTS - 1);
+    const start = helper.now();
+    for (let i = 0; i < SNAPSHOTS; i++) {
+      while (i > 0 && helper.now() - start < interval * i) {
+        await round(inputs, rounds++);
+      }
+      // Only totals are kept in between, so the harness itself
+      // retains the same amount at every snapshot
+      files.push(snapshot(dir, i));
+      marks.push({ rounds, handles: handles(),
+        bytes: tally(files[i]).bytes });
+    }
+
+    first = tally(files[0]);
+    last = tally(files[files.length - 1]);
+  } finally {
+    console.log = log;
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+
+  const ran = marks[marks.length - 1].rounds - marks[0].rounds;
+  const heap_growth = last.bytes - first.bytes;
+  const handle_growth = marks[marks.length - 1].handles - marks[0].handles;
+
+  helper.table(`soak, ${inputs.length} inputs, ${ran} rounds over ` +
+    `${SECONDS}s`, ['snapshot', 'rounds', 'retained KiB', 'handles'],
+  marks.map((mark, i) => [i, mark.rounds,
+    fmt(mark.bytes / 1024, 0), mark.handles]));
+
+  // A constructor leaking along with the rounds gains at least one
+  // instance each round
+  const grown = growth(first, last);
+  const leaking = grown.filter((g) => g.count >= ran);
+
+  if (grown.length) {
+    helper.table('retained growth by constructor, first to last snapshot',
+      ['constructor', 'count', 'KiB'], grown.slice(0, TOP).map((g) =>
+        [g.name, `+${g.count}`, fmt(g.bytes / 1024, 1)]));
+  }
+
+  const ok = heap_growth <= MAX_GROWTH && handle_growth <= MAX_HANDLES &&
+    !leaking.length;
+
+  if (!ok) {
+    console.error(`\nretained heap +${fmt(heap_growth / 1024, 0)} KiB, ` +
+      `handles +${handle_growth}` + (leaking.length ?
+        `, leaking: ${leaking.slice(0, TOP).map((g) => g.name).join(', ')}` :
+        ''));
+  }
+
+  return ok;
+}
+
+helper.main(module, run);
+module.exports = run;
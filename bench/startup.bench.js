@@ -0,0 +1,190 @@
+/**
+ * @fileOverview
+ * CLI cold start benchmark.
+ *
+ * Spawns the cli on a tiny input and measures the time until its first
+ * byte of output. The plain `transform <input>` fast path is compared
+ * against an invocation going through the argument parser, and against
+ * the startup snapshot when one has been built (see build/snapshot.js).
+ *
+ * Also measures the time to require the abstractor, which the fast path
+ * loads, and fails when a plain transform of the tiny input ends up
+ * loading any of the optional stages it defers, or when deferring them
+ * no longer saves any time.
+ *
+ * @name startup.bench.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const spawn = require('child_process').spawn;
+const execFileSync = require('child_process').execFileSync;
+const spawnSync = require('child_process').spawnSync;
+const helper = require('./helper');
+const fmt = helper.fmt;
+
+const ROOT = path.resolve(__dirname, '..');
+const BIN = path.join(ROOT, 'bin', 'c-ast.js');
+const BLOB = path.join(ROOT, 'dist', 'c-ast.blob');
+
+/**
+ * Spawns per mode, the median is reported.
+ */
+const RUNS = 15;
+
+const TINY = '/* Entry point */\nint main(void);\n';
+
+/**
+ * Stages the abstractor only requires when they are used.
+ */
+const LAZY = ['memory', 'scheduler', 'search', 'serializer', 'compression',
+  'preprocessor', 'decl', 'types'];
+
+/**
+ * Milliseconds from spawn until the first stdout chunk.
+ *
+ * @param {array} args node arguments
+ * @return {Promise<number>}
+ */
+function first_output(args) {
+  return new Promise((resolve, reject) => {
+    const start = helper.now();
+    let first = 0;
+
+    const child = spawn(process.execPath, args,
+      { stdio: ['ignore', 'pipe', 'ignore'] });
+
+    child.stdout.once('data', () => {
+      first = helper.now() - start;
+    });
+    child.stdout.resume();
+    child.on('error', reject);
+    child.on('close', (code) => {
+      if (code !== 0 || !first) {
+        reject(new Error(`cli exited with ${code}: ${args.join(' ')}`));
+      } else {
+        resolve(first);
+      }
+    });
+  });
+}
+
+function median(values) {
+  const sorted = values.slice().sort((a, b) => a - b);
+  return sorted[sorted.length >> 1];
+}
+
+async function measure(args) {
+  const times = [];
+  for (let i = 0; i < RUNS; i++) {
+    times.push(await first_output(args));
+  }
+  return { median: median(times), min: Math.min(...times) };
+}
+
+/**
+ * Time to require the abstractor in a fresh process, along with the
+ * given stages.
+ *
+ * @param {array} stages lazy stages required after the abstractor
+ * @return {number} ms
+ */
+function require_time(stages) {
+  const lib = path.join(ROOT, 'lib');
+  const script = `
+    const start = process.hrtime.bigint();
+    require(${JSON.stringify(path.join(lib, 'abstractor'))});
+    for (const stage of ${JSON.stringify(stages)}) {
+      require(${JSON.stringify(lib)} + '/' + stage);
+    }
+    console.log(Number(process.hrtime.bigint() - start) / 1e6);`;
+
+  return Number(execFileSync(process.execPath, ['-e', script]));
+}
+
+function measure_require(stages) {
+  const times = [];
+  for (let i = 0; i < RUNS; i++) {
+    times.push(require_time(stages));
+  }
+  return { median: median(times), min: Math.min(...times) };
+}
+
+/**
+ * Lazy stages loaded once the cli has transformed an input, through the
+ * same entry point and arguments as a plain invocation.
+ *
+ * @param {string} input path
+ * @return {array} stage names
+ */
+function transform_loads(input) {
+  const lib = path.join(ROOT, 'lib');
+  const script = `
+    process.on('exit', () => {
+      const loaded = ${JSON.stringify(LAZY)}.filter((stage) =>
+        require.cache[${JSON.stringify(lib)} + '/' + stage + '.js']);
+      process.stderr.write(JSON.stringify(loaded));
+    });
+    process.argv = [process.argv[0], ${JSON.stringify(BIN)}, 'transform',
+      ${JSON.stringify(input)}];
+    require(${JSON.stringify(BIN)});`;
+
+  // The stage list is written last, after whatever the cli logged
+  const err = spawnSync(process.execPath, ['-e', script],
+    { encoding: 'utf8' }).stderr;
+  return JSON.parse(err.slice(err.lastIndexOf('[')));
+}
+
+async function run() {
+  const input = path.join(os.tmpdir(), `c-ast-startup-${process.pid}.h`);
+  fs.writeFileSync(input, TINY);
+
+  const modes = [
+    ['node (hello world)', ['-e', 'console.log(1)']],
+    ['transform', [BIN, 'transform', input]],
+    ['transform (parsed args)', [BIN, 'transform', input, '--members']],
+  ];
+
+  if (fs.existsSync(BLOB)) {
+    modes.push(['transform (snapshot)',
+      ['--snapshot-blob', BLOB, 'transform', input]]);
+  }
+
+  const results = {};
+  let loaded;
+  try {
+    for (const [name, args] of modes) {
+      results[name] = await measure(args);
+    }
+    loaded = transform_loads(input);
+  } finally {
+    fs.unlinkSync(input);
+  }
+
+  helper.table(`time to first output, ${RUNS} runs`,
+    ['mode', 'median ms', 'min ms'],
+    modes.map(([name]) =>
+      [name, fmt(results[name].median), fmt(results[name].min)]));
+
+  const lazy = measure_require([]);
+  const eager = measure_require(LAZY);
+  helper.table(`time to require the abstractor, ${RUNS} runs`,
+    ['mode', 'median ms', 'min ms'],
+    [['abstractor', fmt(lazy.median), fmt(lazy.min)],
+      ['with optional stages', fmt(eager.median), fmt(eager.min)]]);
+
+  if (loaded.length) {
+    console.error(`!! transform loads ${loaded.join(', ')}`);
+    return false;
+  }
+
+  return results['transform'].median <
+    results['transform (parsed args)'].median &&
+    lazy.median < eager.median;
+}
+
+helper.main(module, run);
+module.exports = run;
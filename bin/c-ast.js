@@ -1,8 +1,4 @@
 #!/usr/bin/env node
-const cast = require('c-ast');
-if (cast) {
-  cast.cli.exec();
-} else {
-  console.error("c-ast library not found");
-  console.error("try installing it with `npm i -g c-ast`")
-}
+// Loads the cli module alone, rather than the whole library index,
+// so that startup only pays for what the command uses.
+require('../lib/cli').exec();
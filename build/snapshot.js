@@ -0,0 +1,115 @@
+/**
+ * @fileOverview
+ * Builds a V8 startup snapshot of the initialized parser and cli.
+ *
+ * `node --build-snapshot` only accepts a single script requiring built-in
+ * modules, so the lib modules are first bundled into one file. Any other
+ * dependency (ie. yargs) is resolved from disk at runtime, on demand.
+ *
+ * Usage:
+ *   node build/snapshot.js [blob]
+ *   node --snapshot-blob dist/c-ast.blob transform <input>
+ *
+ * @name snapshot.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const v8 = require('v8');
+const spawnSync = require('child_process').spawnSync;
+
+const ROOT = path.resolve(__dirname, '..');
+const LIB = path.join(ROOT, 'lib');
+const DIST = path.join(ROOT, 'dist');
+
+/**
+ * Modules initialized into the snapshot, ahead of deserialization.
+ */
+const PRELOAD = ['./abstractor', './cli'];
+
+/**
+ * Wraps every lib module into a single script.
+ *
+ * @return {string} bundle source
+ */
+function bundle() {
+  const modules = fs.readdirSync(LIB)
+    .filter((f) => f.endsWith('.js'))
+    .sort()
+    .map((f) => {
+      const src = fs.readFileSync(path.join(LIB, f), 'utf8');
+      return `  ${JSON.stringify('./' + path.basename(f, '.js'))}: ` +
+        `function(module, exports, require) {\n${src}\n},`;
+    });
+
+  // Left in sloppy mode, like the lib modules themselves.
+  return `const v8 = require('v8');
+const Module = require('module');
+
+const LIB = ${JSON.stringify(LIB)};
+
+const sources = {
+${modules.join('\n')}
+};
+
+const cache = {};
+
+// Resolves bundled modules first, then built-ins, then anything else
+// from the installed lib directory.
+function load(name) {
+  if (cache[name]) {
+    return cache[name].exports;
+  }
+
+  if (sources[name]) {
+    const module = cache[name] = { exports: {} };
+    sources[name](module, module.exports, load);
+    return module.exports;
+  }
+
+  if (Module.isBuiltin(name)) {
+    return require(name);
+  }
+
+  return Module.createRequire(LIB + '/cli.js')(name);
+}
+
+${PRELOAD.map((m) => `load(${JSON.stringify(m)});`).join('\n')}
+
+v8.startupSnapshot.setDeserializeMainFunction(() => {
+  load('./cli').exec();
+});
+`;
+}
+
+function build() {
+  if (!v8.startupSnapshot) {
+    console.error('Startup snapshots require node >= 18.20');
+    return 1;
+  }
+
+  const blob = path.resolve(process.argv[2] || path.join(DIST, 'c-ast.blob'));
+  const entry = path.join(DIST, 'c-ast.snapshot.js');
+
+  fs.mkdirSync(path.dirname(blob), { recursive: true });
+  fs.mkdirSync(DIST, { recursive: true });
+  fs.writeFileSync(entry, bundle());
+
+  const result = spawnSync(process.execPath, [
+    '--snapshot-blob', blob, '--build-snapshot', entry,
+  ], { stdio: 'inherit' });
+
+  if (result.status !== 0) {
+    console.error('Failed to build the startup snapshot');
+    return 1;
+  }
+
+  console.log(`Startup snapshot written to ${path.relative(ROOT, blob)}`);
+  console.log(`Run with: node --snapshot-blob ${path.relative(ROOT, blob)}` +
+    ' transform <input>');
+  return 0;
+}
+
+process.exitCode = build();
@@ -1,5 +1,11 @@
-const cli = require('./lib/cli');
 const abstract = require('./lib/abstractor');
+const NodePool = require('./lib/pool').NodePool;
+const SnapshotStore = require('./lib/snapshot').SnapshotStore;
+const Scheduler = require('./lib/scheduler').Scheduler;
+const TypeTable = require('./lib/types').TypeTable;
+const shared = require('./lib/shared');
+const CommentIndex = require('./lib/search').CommentIndex;
+const InternPool = require('./lib/intern').InternPool;
 
 const ast_from_file = abstract.ast_from_file;
 const ast_from_text = abstract.ast_from_text;
@@ -9,6 +15,22 @@ module.exports = {
   ast_from_file,
   ast_from_text,
   ast_from_stream,
-  cli
+  NodePool,
+  SnapshotStore,
+  Scheduler,
+  TypeTable,
+  share: shared.share,
+  SharedAST: shared.SharedAST,
+  CommentIndex,
+  InternPool,
+
+  // Required on first access, api consumers rarely need these
+  get cli() {
+    return require('./lib/cli');
+  },
+
+  get symbols() {
+    return require('./lib/symbols');
+  },
 }
 
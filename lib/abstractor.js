@@ -12,14 +12,27 @@ const fs = require('fs');
 const exists = fs.existsSync;
 
 const readline = require('readline');
+const Readable = require('stream').Readable;
 const resolve = require('path').resolve;
 
 const logger = require('./utils').logger;
 const tokenizer = require('./tokenizer');
 const scope = require('./scope');
 const node = require('./node');
+const classifier = require('./classifier');
+const S = require('./state');
 const C = require('./constants');
 
+// Optional stages are required lazily, behind the options enabling them,
+// to keep cold starts short: the preprocessor, member declarations and
+// their type table, memory sampling, the scheduler, the comment index and
+// decompression of compressed input.
+
+/**
+ * Preprocessor front stage, once required.
+ */
+let preprocessor = null;
+
 /**
  * Panic flag.
  * If triggered - promises will cease processing data.
@@ -31,6 +44,17 @@ let PANIC = false;
  */
 const log = logger('processor');
 
+/**
+ * Lines buffered ahead of a sliced parse before its input is paused.
+ */
+const HIGH_WATER = 16384;
+const LOW_WATER = 4096;
+
+/**
+ * Lines processed in between deadline checks of a slice.
+ */
+const SLICE_CHECK = 16;
+
 /**
  * Process individual lines fed by the buffer stream.
  *
@@ -39,9 +63,14 @@ const log = logger('processor');
  * @param {string} line being fed in this iteration.
  */
 function process_line(ast, state, line) {
+  // Share identical lines with the other ASTs of a batch
+  if (ast.strings) {
+    line = ast.strings.line(line);
+  }
+
   // Clear per line specific state;
   state.node = null;
-  state.closing = {};
+  state.closing = 0;
   state.block_start = false;
   state.current_line = line;
   state.ln = line.trim();
@@ -50,19 +79,37 @@ function process_line(ast, state, line) {
   ast.source.push(line);
   state.lno++;
 
+  // /////////////////////////////////////////////
+  // Skip disabled regions and continued directives
+  let directive = false;
+  if (state.pp) {
+    const stage = preprocessor.line(ast, state);
+    if (stage == preprocessor.CONSUMED) {
+      return;
+    }
+    directive = stage == preprocessor.DIRECTIVE;
+  }
+
   const inside = state.inside;
 
   // /////////////////////////////////////////////
   // Ignore non-applicable lines
-  if (!inside[C.COMM] && state.ln == '') {
+  if (!(inside & S.IN_COMM) && state.ln == '') {
     // Clear prev tracking as we have introduced an association break
-    if (!inside[C.CODE] && !inside[C.DEF]) {
-      state.previous = {};
+    if (!(inside & (S.IN_CODE | S.IN_DEF))) {
+      state.previous.fill(S.NONE);
     } else {
-      delete state.previous[C.COMM];
+      state.previous[S.COMM] = S.NONE;
     }
   }
 
+  // /////////////////////////////////////////////
+  // Classify line features in a single pass
+  classifier.scan(state.ln, state.scan);
+  if (directive) {
+    preprocessor.neutral(state.scan);
+  }
+
   // /////////////////////////////////////////////
   // Detect tokens
   tokenizer(ast, state);
@@ -77,15 +124,8 @@ function process_line(ast, state, line) {
 
   // /////////////////////////////////////////////
   // Create associations
-  if (state.block_start || state.inside[C.DEF]) {
-    let related = node.find_precedence(ast, state, state.node);
-
-    if (related) {
-      node.associate(ast, state.node, related);
-      if (state.previous[related.type] == related.id) {
-        delete state.previous[related.type];
-      }
-    }
+  if (state.block_start || (state.inside & S.IN_DEF)) {
+    node.relate(ast, state);
   }
 
   // /////////////////////////////////////////////
@@ -93,49 +133,32 @@ function process_line(ast, state, line) {
   scope.iterate(ast, state);
 }
 
-/**
- * Creates an empty State object
- * @return {object} Fresh state
- */
-function create_state() {
-  return {
-    // Scope presence tracking structs
-    inside: {},
-    current: {},
-    previous: {},
-
-    // Scope depth tracking
-    depth: 0,
-    lno: -1,
-
-    // Runtime config
-    config: {
-      [C.COMM]: { ref: C.CODE, container: C.COMM },
-      [C.CODE]: { ref: C.COMM, container: C.CODE },
-      [C.MEMB]: { ref: C.DEF, container: C.DEF },
-      [C.DEF]: { ref: C.COMM, container: C.DEF },
-      [C.CHAR]: { ref: C.COMM, container: C.CHAR },
-    },
-  };
-}
-
 /**
  * Creates an AST structure with internal book keeping methods
  * @return {object} Empty AST C.DEFinition
  */
-function create_ast_struct() {
+function create_ast_struct(peak = null) {
   const ast = {
     source: [],
     [C.COMM]: {},
     [C.CODE]: {},
     [C.DEF]: {},
     [C.CHAR]: {},
+    [C.SKIP]: {},
     index: {},
+    // Member type names, when member declarations are decomposed
+    types: null,
+    // First and last line parsed, when only part of the input was
+    range: null,
+    // Trigram index of comment text, when searchable
+    search: null,
+    // References into a shared intern pool, when interning
+    strings: null,
   };
 
   /**
    * Gets an array of keys inside the given AST container type.
-   *   Possible values are constants: C.COMM,C.CODE,C.DEF
+   *   Possible values are constants: C.COMM,C.CODE,C.DEF,C.CHAR,C.SKIP
    *
    * @param {string} container type of AST container.
    * @return {array} array of item keys inside the container
@@ -164,12 +187,42 @@ function create_ast_struct() {
     return results;
   };
 
+  /**
+   * Finds the comment nodes holding a substring, through the trigram
+   * index built with the `search` option.
+   *
+   * @param {string} query substring searched for
+   * @param {object|optional} opts { ignore_case }
+   * @return {array} matching comment nodes, by line
+   */
+  ast.searchComments = (query, opts) => {
+    if (!ast.search) {
+      log.error('searchComments() needs an AST generated with search');
+      return [];
+    }
+
+    const found = new Set();
+    const nodes = [];
+    for (const match of ast.search.search(query, opts)) {
+      const n = ast[C.COMM][match.id];
+      if (n && !found.has(n)) {
+        found.add(n);
+        nodes.push(n);
+      }
+    }
+    return nodes;
+  };
+
   ast.count = (container) => {
     const c = ast.keys(container).length;
     return { [container]: c };
   };
 
   ast.node = (id) => {
+    if (!ast.index) {
+      return find_node(ast, id);
+    }
+
     const index = ast.index[id];
     if (!index) {
       log.error(`node(${id}) not found in the index`);
@@ -187,6 +240,13 @@ function create_ast_struct() {
     }
   };
 
+  /**
+   * Serializes the tree, pretty printed unless `compact`, and with the
+   * line index unless `skip_index`.
+   *
+   * @param {object|optional} opts { compact, skip_index }
+   * @return {string}
+   */
   ast.json = (opts = {}) => {
     const data = {
       nodes: {
@@ -197,18 +257,58 @@ function create_ast_struct() {
       }
     };
 
-    if (!opts.skip_index) {
+    // Disabled regions, only found when preprocessing
+    for (const id in ast[C.SKIP]) {
+      data.nodes[C.SKIP] = ast[C.SKIP];
+      break;
+    }
+
+    // Type names referenced by member declarations
+    if (ast.types && ast.types.size) {
+      data.types = ast.types;
+    }
+
+    if (!opts.skip_index && ast.index) {
       data.index = ast.index;
     }
 
-    return JSON.stringify(data, null, '    ');
+    return opts.compact ? JSON.stringify(data) :
+      JSON.stringify(data, null, '    ');
   }
+
+  /**
+   * Estimates the bytes retained by each container, along with the
+   * peak process and heap usage sampled while parsing when generated
+   * with the memory option.
+   *
+   * @return {object} memory report
+   */
+  ast.memoryStats = () => {
+    return require('./memory').stats(ast, peak);
+  };
+
   return ast;
 }
 
+/**
+ * Looks up a top level node by id without the line index.
+ *
+ * @param {object} ast tree
+ * @param {number|string} id of the node
+ * @return {object|undefined} node
+ */
+function find_node(ast, id) {
+  for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR, C.SKIP]) {
+    if (ast[type][id]) {
+      return ast[type][id];
+    }
+  }
+}
+
 /**
  *  Transforms input file into AST, redirected to stdout.
  * @param {string} input - file path input
+ * @param {object} opts - generation options, see ast_gen
  * @return {AST} returns ast object tree
  **/
 async function ast_from_file(input, opts = {}) {
@@ -225,39 +325,142 @@ async function ast_from_file(input, opts = {}) {
 /**
  *  Transforms input text into AST redirected to stdout.
  * @param {string} input - text input string
+ * @param {object} opts - generation options, see ast_gen
  * @return {AST} returns AST object tree
  **/
-async function ast_from_text(text) {
-  const buffer = new streamBuffers.ReadableStreamBuffer({
-    frequency: 10,   // in milliseconds.
-    chunkSize: 32 * 2048  // in bytes.
-  });
-
+async function ast_from_text(text, opts = {}) {
   const input = readline.createInterface({
-    input: buffer, terminal: false
+    input: Readable.from([text || ""]), terminal: false
   });
 
-  buffer.put(text || "");
-  buffer.stop();
-
-  return await ast_gen(input);
+  return await ast_gen(input, opts);
 }
 
 /**
  * Generate an Abstract Syntax Tree from source buffer stream
  *
+ * Options:
+ *   pool    - NodePool recycling nodes of previously released ASTs.
+ *   only    - node kinds to extract, eg. ['code', 'comments'] or
+ *             'code,comments'. Work for other kinds is skipped.
+ *   members - false to skip struct members.
+ *   index   - false to skip building the per line index.
+ *   slice   - milliseconds of parsing per event loop turn. Without it,
+ *             lines are parsed as soon as they are read.
+ *   priority - 'interactive', 'normal' or 'background', for sliced
+ *             parses sharing a scheduler.
+ *   scheduler - Scheduler running the slices, a shared one by default.
+ *   preprocess - true to skip preprocessor disabled regions, recorded as
+ *             'skip' span nodes. Implied by defines and undefines.
+ *   defines - macros taken as defined, eg. ['NK_IMPLEMENTATION'].
+ *   undefines - macros taken as not defined.
+ *   decl    - true to decompose struct and enum members into a `decl`.
+ *   types   - TypeTable member type names are interned into, to share
+ *             a single dictionary between the ASTs of a project.
+ *             Implies decl.
+ *   search  - true to index comment text by trigram, for searchComments.
+ *   memory  - true to sample peak process and heap usage while parsing,
+ *             reported by memoryStats along with the retained estimates.
+ *   intern  - InternPool source lines and member identifiers are shared
+ *             through, between the ASTs of a batch. Release each AST
+ *             from the pool once it is no longer used.
+ *
  * @param {buffer} buffer input
+ * @param {object} opts generation options
  * @return {object} AST definition
  */
-function ast_gen(buffer) {
+function ast_gen(buffer, opts = {}) {
+  let ast, state, peak;
+  try {
+    ({ ast, state, peak } = setup(opts));
+    if (opts.slice) {
+      require('./scheduler').level(opts.priority);
+    }
+  } catch (err) {
+    return Promise.reject(err);
+  }
+
+  // Asyncronously process our buffer into an AST
+  if (opts.slice) {
+    return compute_sliced(ast, state, buffer, peak, opts);
+  }
+  return compute(ast, state, buffer, peak);
+}
+
+/**
+ * Creates an empty tree along with the parser state of a generation.
+ * Throws on invalid options.
+ *
+ * @param {object} opts generation options, see ast_gen
+ * @return {object} { ast, state, peak }
+ */
+function setup(opts) {
   // Create an empty ast tree to start with
-  const ast = create_ast_struct();
+  const peak = opts.memory ? require('./memory').create_peak() : null;
+  const ast = create_ast_struct(peak);
 
   // Setup state for C.CODE parsing
-  const state = create_state();
+  const state = S.create_state(opts);
 
-  // Asyncronously process our buffer into an AST
-  return compute(ast, state, buffer);
+  if (!state.indexed) {
+    ast.index = null;
+  }
+
+  if (opts.preprocess || opts.defines || opts.undefines) {
+    preprocessor = preprocessor || require('./preprocessor');
+    state.pp = preprocessor.create(opts);
+  }
+
+  if (state.decls) {
+    const TypeTable = require('./types').TypeTable;
+    ast.types = opts.types || new TypeTable();
+  }
+
+  if (opts.search) {
+    const CommentIndex = require('./search').CommentIndex;
+    ast.search = new CommentIndex();
+  }
+
+  if (opts.intern) {
+    ast.strings = opts.intern.lease();
+  }
+
+  return { ast, state, peak };
+}
+
+/**
+ * Synchronous parser fed one line at a time by the caller, eg. to parse
+ * part of a file. Throws on invalid options.
+ *
+ * @param {object} opts generation options, see ast_gen
+ * @return {object} { ast, state, line(text), end() }
+ */
+function parser(opts = {}) {
+  const { ast, state, peak } = setup(opts);
+  const memory = peak && require('./memory');
+
+  return {
+    ast,
+    state,
+
+    line(text) {
+      process_line(ast, state, text);
+
+      if (peak && state.lno % memory.SAMPLE_LINES == 0) {
+        memory.sample(peak);
+      }
+    },
+
+    end() {
+      if (state.pp) {
+        preprocessor.finish(ast, state);
+      }
+      if (peak) {
+        memory.sample(peak);
+      }
+      return ast;
+    },
+  };
 }
 
 /**
@@ -265,34 +468,183 @@ function ast_gen(buffer) {
  * @param {object} ast 
  * @param {object} state 
  * @param {buffer} buffer
+ * @param {object|null} peak memory usage record, sampled as lines are
+ *   parsed when memory stats are requested
  */
-function compute(ast, state, buffer) {
+function compute(ast, state, buffer, peak) {
+  const memory = peak && require('./memory');
+
   return new Promise((resolve, reject) => {
     buffer.on('line', (line) => {
       if (PANIC) { return; }
       process_line(ast, state, line);
+
+      if (peak && state.lno % memory.SAMPLE_LINES == 0) {
+        memory.sample(peak);
+      }
     });
 
     buffer.on('close', (fin) => {
+      if (state.pp) {
+        preprocessor.finish(ast, state);
+      }
+      if (peak) {
+        memory.sample(peak);
+      }
       resolve(ast);
     });
   });
 }
 
+/**
+ * Compute processing in time slices.
+ * Lines are queued as they are read and parsed in slices of the given
+ * budget, yielding to the event loop in between.
+ *
+ * @param {object} ast
+ * @param {object} state
+ * @param {buffer} buffer
+ * @param {object|null} peak memory usage record, sampled as lines are
+ *   parsed when memory stats are requested
+ * @param {object} opts generation options, see ast_gen
+ */
+function compute_sliced(ast, state, buffer, peak, opts) {
+  const memory = peak && require('./memory');
+  const scheduler = require('./scheduler');
+  const runner = opts.scheduler || scheduler.Scheduler.shared();
+
+  return new Promise((resolve, reject) => {
+    let queue = [];
+    let head = 0;
+    let closed = false;
+    let paused = false;
+    let scheduled = false;
+    let failed = false;
+
+    const step = (deadline) => {
+      if (failed) {
+        return false;
+      }
+
+      try {
+        while (head < queue.length && !PANIC) {
+          process_line(ast, state, queue[head++]);
+
+          if (peak && state.lno % memory.SAMPLE_LINES == 0) {
+            memory.sample(peak);
+          }
+
+          if (head % SLICE_CHECK == 0 && scheduler.now() >= deadline) {
+            break;
+          }
+        }
+      } catch (err) {
+        failed = true;
+        reject(err);
+        return false;
+      }
+
+      if (head == queue.length) {
+        queue = [];
+        head = 0;
+      }
+
+      if (paused && queue.length - head < LOW_WATER) {
+        paused = false;
+        buffer.resume();
+      }
+
+      if (head < queue.length) {
+        return true;
+      }
+
+      scheduled = false;
+      if (closed) {
+        if (state.pp) {
+          preprocessor.finish(ast, state);
+        }
+        if (peak) {
+          memory.sample(peak);
+        }
+        resolve(ast);
+      }
+      return false;
+    };
+
+    const kick = () => {
+      if (!scheduled) {
+        scheduled = true;
+        runner.schedule(step, opts.priority, opts.slice);
+      }
+    };
+
+    buffer.on('line', (line) => {
+      queue.push(line);
+
+      if (!paused && queue.length - head > HIGH_WATER) {
+        paused = true;
+        buffer.pause();
+      }
+      kick();
+    });
+
+    buffer.on('close', (fin) => {
+      closed = true;
+      kick();
+    });
+  });
+}
+
+/**
+ * Whether an input file may need decompressing, telling plain input
+ * apart without loading compression: gzip starts with its magic bytes,
+ * brotli is named `.br`. See compression.js.
+ *
+ * @param {string} ipath filename
+ * @return {boolean}
+ */
+function compressed(ipath) {
+  if (ipath.endsWith('.br')) {
+    return true;
+  }
+
+  const head = Buffer.alloc(2);
+  const fd = fs.openSync(ipath, 'r');
+  try {
+    return fs.readSync(fd, head, 0, 2, 0) == 2 &&
+      head[0] == 0x1f && head[1] == 0x8b;
+  } finally {
+    fs.closeSync(fd);
+  }
+}
+
 /**
  * Parses input file path and returns AST result.
+ * Gzip and brotli input is decompressed as it is read.
  * @param {string} ipath filename
+ * @param {object} opts generation options
  * @return {object} ast tree
  */
-async function process_ast(ipath) {
+async function process_ast(ipath, opts) {
   // Stream input into a sizable buffer to work with,
   // Consuming the stream line by line.
+  const input = compressed(ipath) ?
+    require('./compression').reader(ipath) : fs.createReadStream(ipath);
   const reader = readline.createInterface({
-      input: fs.createReadStream(ipath),
+      input,
       console: false,
   });
 
-  const ast = await ast_gen(reader);
+  // Read and decompression errors are forwarded by readline, and fail
+  // the parse rather than leave it waiting for more lines.
+  const failed = new Promise((resolve, reject) => {
+    reader.on('error', (err) => {
+      reject(err);
+      reader.close();
+    });
+  });
+
+  const ast = await Promise.race([ast_gen(reader, opts), failed]);
   return ast;
 }
 
@@ -304,5 +656,6 @@ module.exports = {
   ast_from_file,
   ast_from_text,
   // AST generation
-  ast_gen
+  ast_gen,
+  parser
 };
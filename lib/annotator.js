@@ -20,15 +20,13 @@ const colorize = utils.colorize;
 const logger = utils.logger;
 const C = require('./constants');
 const ast_from_file = require('./abstractor').ast_from_file;
+const checkpoint = require('./checkpoint');
 const proc = require('process');
 
 /**
  * Utility log namespaced helper
  */
 const log = logger('annotator');
-const options = {};
-let dyn_width = 0;
-let dyn_thres = 0;
 
 const colors = {
     comments: 'blue',
@@ -38,8 +36,29 @@ const colors = {
     members:  'green',
 }
 
-function padding(data) {
+/**
+ * Settings and padding state of a single annotation run, kept per call
+ * so that long running processes annotating many files carry nothing
+ * over from one file to the next.
+ *
+ * @param {object} opts annotate_file options
+ * @return {object}
+ */
+function create_options(opts) {
+    return {
+        colorize: !!opts.colorize,
+        range: undefined,
+        start: undefined,
+        end: undefined,
+        dyn_width: 0,
+        dyn_thres: 0,
+    };
+}
+
+function padding(options, data) {
     let pad;
+    let dyn_width = options.dyn_width;
+    let dyn_thres = options.dyn_thres;
     const width = 120;
     const max = width > dyn_width ? width : dyn_width;
     const min = 120;
@@ -73,10 +92,12 @@ function padding(data) {
 
     if (pad <= 0) { pad = 1;}
 
+    options.dyn_width = dyn_width;
+    options.dyn_thres = dyn_thres;
     return ' '.repeat(pad);
 }
 
-function annotate_line(ast, n, i) {
+function annotate_line(options, ast, n, i) {
     if (options.range) {
         let int = parseInt(i);
         if (int < options.start || int > options.end) {
@@ -110,7 +131,7 @@ function annotate_line(ast, n, i) {
     Object.assign(attrs, n.assocs);
 
     const info = JSON.stringify(attrs);
-    const annot = `${padding(data)}// ${i}.${n.type} @${n.id},${info}`;
+    const annot = `${padding(options, data)}// ${i}.${n.type} @${n.id},${info}`;
     const line = data + annot;
 
     if (options.colorize) {
@@ -121,12 +142,12 @@ function annotate_line(ast, n, i) {
     }
 }
 
-function parse_range(range) {
+function parse_range(options, range) {
     if (range) {
         options.range = range;
         if (typeof range == 'string' && range.indexOf(',') >= 0) {
             options.start = parseInt((range.split && range.split(',')[0]) || range);
-            options.end = parseInt(range.split && range.split(',')[1] || start + 5);
+            options.end = parseInt(range.split && range.split(',')[1] || options.start + 5);
         } else {
             range = parseInt(range);
             options.start = range;
@@ -147,26 +168,30 @@ function parse_range(range) {
  */
 async function annotate_file(file, opts = {}) {
     log(`annotating file: ${file}`)
-    const ast = await ast_from_file(file);
-    parse_range(opts.range);
-
-    if (opts.colorize) {
-        options.colorize = true;
-    }
 
-    for (i in ast.index) {
+    // Ranges only parse the nodes enclosing them, resuming from the
+    // checkpoints of the file when available.
+    const ast = opts.range !== undefined ?
+        checkpoint.range(file, ...checkpoint.bounds(opts.range), {
+            checkpoints: opts.checkpoints
+        }) :
+        await ast_from_file(file);
+    const options = create_options(opts);
+    parse_range(options, opts.range);
+
+    for (const i in ast.index) {
         let n;
         let container;
         const lookup = ast.index[i];
 
-        if (lookup.parent) {
+        if (lookup.parent !== undefined) {
             n = node.root(ast, lookup.parent);
         } else {
             container = ast[lookup.type];
             n = container[lookup.node_id];
         }
 
-        annotate_line(ast, n, i)
+        annotate_line(options, ast, n, i)
     }
 
 }
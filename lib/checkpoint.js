@@ -0,0 +1,277 @@
+/**
+ * @fileOverview
+ * Parser checkpoints for partial parsing of line ranges.
+ *
+ * A full parse may record a sidecar of checkpoints, one about every N
+ * lines, holding the byte offset and parser state a parse can resume
+ * from. Checkpoints are only taken at blank lines of the root scope: no
+ * node spans them and they break associations, so parsing on from there
+ * builds the same nodes a full parse does.
+ *
+ * A range request resumes from the closest checkpoint before the range,
+ * and stops at the first such boundary after it, parsing only the top
+ * level nodes enclosing the range.
+ *
+ * @name checkpoint.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+
+const logger = require('./utils').logger;
+const parser = require('./abstractor').parser;
+const lines = require('./lines');
+
+/**
+ * Utility log namespaced helper
+ */
+const log = logger('checkpoint');
+
+/**
+ * Sidecar format version, bumped whenever the parser state layout changes.
+ */
+const VERSION = 1;
+
+/**
+ * Sidecar file name suffix, appended to the parsed file path.
+ */
+const SUFFIX = '.c-ast-ckpt.json';
+
+/**
+ * Default number of lines in between checkpoints.
+ */
+const DEFAULT_EVERY = 1024;
+
+/**
+ * Default sidecar location of a file.
+ *
+ * @param {string} file parsed file
+ * @return {string} sidecar path
+ */
+function sidecar_path(file) {
+  return path.resolve(file) + SUFFIX;
+}
+
+/**
+ * Size and modification time identifying a version of a file.
+ */
+function stamp(file) {
+  const st = fs.statSync(file);
+  return { size: st.size, mtime: st.mtimeMs };
+}
+
+/**
+ * Loads the checkpoints of a file, unless missing or outdated.
+ *
+ * @param {string} file parsed file
+ * @param {string|optional} sidecar path, next to the file by default
+ * @return {object|null} sidecar
+ */
+function load(file, sidecar) {
+  sidecar = sidecar || sidecar_path(file);
+
+  try {
+    const data = JSON.parse(fs.readFileSync(sidecar, 'utf8'));
+    const current = stamp(file);
+
+    if (data.version === VERSION && data.size === current.size &&
+      data.mtime === current.mtime && Array.isArray(data.points)) {
+      return data;
+    }
+  } catch (err) {
+    if (err.code != 'ENOENT') {
+      log.error(`Discarding unreadable checkpoints: ${sidecar}`);
+    }
+  }
+
+  return null;
+}
+
+/**
+ * Writes a sidecar atomically, so readers never see a partial file.
+ */
+function save(sidecar, data) {
+  const tmp = `${sidecar}.${process.pid}.tmp`;
+  fs.writeFileSync(tmp, JSON.stringify(data));
+  fs.renameSync(tmp, sidecar);
+}
+
+/**
+ * Whether the next line starts at a root boundary: a blank line while
+ * no scope is open.
+ *
+ * @param {object} state Parser State, after the previous line
+ * @param {string} text next line
+ * @return {boolean}
+ */
+function boundary(state, text) {
+  return state.inside == 0 && state.depth == 0 && text.trim() == '';
+}
+
+/**
+ * Parser state to resume from, ahead of the line at an offset.
+ */
+function record(state, offset) {
+  return {
+    lno: state.lno + 1,
+    offset,
+    depth: state.depth,
+    inside: state.inside,
+    current: Array.from(state.current),
+    previous: Array.from(state.previous),
+  };
+}
+
+/**
+ * Restores a checkpoint into a fresh parser.
+ */
+function resume(p, point) {
+  const state = p.state;
+  state.lno = point.lno - 1;
+  state.depth = point.depth;
+  state.inside = point.inside;
+  state.current.set(point.current);
+  state.previous.set(point.previous);
+
+  // Lines ahead of the checkpoint are never read
+  p.ast.source.length = point.lno;
+}
+
+/**
+ * Last checkpoint at or before a line.
+ *
+ * @param {array} points checkpoints, ordered by line
+ * @param {number} lno line number
+ * @return {object|null} checkpoint
+ */
+function nearest(points, lno) {
+  let lo = 0;
+  let hi = points.length - 1;
+  let found = null;
+
+  while (lo <= hi) {
+    const mid = (lo + hi) >> 1;
+    if (points[mid].lno <= lno) {
+      found = points[mid];
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+
+  return found;
+}
+
+/**
+ * Parses a whole file, recording its checkpoints into a sidecar.
+ *
+ * Checkpoints are not recorded along with the preprocessor stage, whose
+ * conditional state they do not hold.
+ *
+ * Options, along with the generation options of ast_gen:
+ *   checkpoints - lines in between checkpoints.
+ *   sidecar     - sidecar path, next to the file by default.
+ *
+ * @param {string} file path
+ * @param {object} opts
+ * @return {object} AST
+ */
+function build(file, opts = {}) {
+  const every = opts.checkpoints > 0 ? opts.checkpoints : DEFAULT_EVERY;
+  const version = stamp(file);
+  const p = parser(opts);
+  const state = p.state;
+  const points = [];
+  let next = every;
+
+  lines.each(file, 0, (text, offset) => {
+    if (state.lno + 1 >= next && !state.pp && boundary(state, text)) {
+      points.push(record(state, offset));
+      next = state.lno + 1 + every;
+    }
+    p.line(text);
+  });
+
+  save(opts.sidecar || sidecar_path(file), {
+    version: VERSION,
+    size: version.size,
+    mtime: version.mtime,
+    every,
+    lines: state.lno + 1,
+    points,
+  });
+
+  return p.end();
+}
+
+/**
+ * Parses the top level nodes enclosing a range of lines.
+ *
+ * Resumes from the closest checkpoint when the sidecar is up to date,
+ * and from the top of the file otherwise. With the `checkpoints` option,
+ * a missing or outdated sidecar is rebuilt first.
+ *
+ * The resulting AST only holds the nodes parsed, and `ast.range` the
+ * first and last line parsed.
+ *
+ * @param {string} file path
+ * @param {number} start first line of the range
+ * @param {number} end last line of the range
+ * @param {object} opts see build
+ * @return {object} partial AST
+ */
+function range(file, start, end = start, opts = {}) {
+  let data = load(file, opts.sidecar);
+  if (!data && opts.checkpoints) {
+    build(file, opts);
+    data = load(file, opts.sidecar);
+  }
+
+  const p = parser(opts);
+  const state = p.state;
+  const point = data && !state.pp ? nearest(data.points, start) : null;
+
+  if (point) {
+    resume(p, point);
+  }
+
+  lines.each(file, point ? point.offset : 0, (text) => {
+    if (state.lno >= end && boundary(state, text)) {
+      return false;
+    }
+    p.line(text);
+  });
+
+  const ast = p.end();
+  ast.range = { start: point ? point.lno : 0, end: state.lno };
+  return ast;
+}
+
+/**
+ * Parses a range argument, eg. '9000,9050' or '9000'.
+ *
+ * @param {string|number} arg range
+ * @return {array} [start, end]
+ */
+function bounds(arg) {
+  const parts = String(arg).split(',');
+  const start = parseInt(parts[0]);
+  const end = parts.length > 1 ? parseInt(parts[1]) : start;
+
+  if (!(start >= 0) || !(end >= start)) {
+    throw new Error(`Invalid line range: ${arg}`);
+  }
+  return [start, end];
+}
+
+module.exports = {
+  SUFFIX,
+  DEFAULT_EVERY,
+  sidecar_path,
+  load,
+  build,
+  range,
+  bounds,
+};
@@ -0,0 +1,197 @@
+/**
+ * @fileOverview
+ * Single pass line classifier for function, struct and enum tokens,
+ * along with the comment, terminator and brace features the parser
+ * state machine transitions on.
+ *
+ * Replaces the backtracking regex selectors previously used by the
+ * tokenizer. Every character of a line is visited exactly once, so the
+ * worst case cost is linear in the line length regardless of content.
+ *
+ * @name classifier.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+/**
+ * Classification flags, combined into a bitmask result.
+ */
+const FN = 1;
+const STRUCT = 2;
+const ENUM = 4;
+const BLOCK_OPEN = 8;    // line starts with `/*`
+const BLOCK_CLOSE = 16;  // line contains `*/`
+const LINE_COMM = 32;    // line starts with `//`
+const SEMI = 64;         // line contains `;`
+
+/**
+ * Reusable scan result, one per parser state.
+ */
+class Scan {
+  constructor() {
+    this.kind = 0;
+    this.open = 0;
+    this.close = 0;
+    this.semi = -1;
+  }
+}
+
+/**
+ * Whitespace test matching the `\s` regex character class.
+ *
+ * @param {number} c char code
+ * @return {boolean}
+ */
+function is_space(c) {
+  if (c <= 0x20) {
+    return c == 0x20 || (c >= 0x09 && c <= 0x0d);
+  }
+
+  if (c < 0xa0) {
+    return false;
+  }
+
+  return c == 0xa0 || c == 0x1680 ||
+    (c >= 0x2000 && c <= 0x200a) ||
+    c == 0x2028 || c == 0x2029 || c == 0x202f ||
+    c == 0x205f || c == 0x3000 || c == 0xfeff;
+}
+
+/**
+ * Line terminators, which a regex `.` refuses to cross.
+ *
+ * @param {number} c char code
+ * @return {boolean}
+ */
+function is_terminator(c) {
+  return c == 0x0a || c == 0x0d || c == 0x2028 || c == 0x2029;
+}
+
+/**
+ * Characters allowed directly before a function's opening parenthesis.
+ * Mirrors the legacy `[aA0-zZ9_\s]` class, which spans `0` through `z`.
+ *
+ * @param {number} c char code
+ * @return {boolean}
+ */
+function is_decl_char(c) {
+  return (c >= 0x30 && c <= 0x7a) || is_space(c);
+}
+
+/**
+ * Scans a line in one forward pass, filling the given result.
+ *
+ * FN is set when a declaration character is immediately followed by `(`
+ * and a `)` appears later on the same line. STRUCT and ENUM are set when
+ * the keyword is followed by whitespace. Brace counts and the position
+ * of the first `;` are recorded for scope depth tracking.
+ *
+ * @param {string} ln line to scan
+ * @param {Scan} out result to be filled
+ * @return {Scan} the filled result
+ */
+function scan(ln, out) {
+  const len = ln.length;
+  let kind = 0;
+  let open = false;
+  let prev = -1;
+  let braces_open = 0;
+  let braces_close = 0;
+  let semi = -1;
+
+  if (len >= 2 && ln.charCodeAt(0) == 0x2f /* / */) {
+    const c = ln.charCodeAt(1);
+    if (c == 0x2a /* * */) {
+      kind |= BLOCK_OPEN;
+    } else if (c == 0x2f /* / */) {
+      kind |= LINE_COMM;
+    }
+  }
+
+  for (let i = 0; i < len; i++) {
+    const c = ln.charCodeAt(i);
+
+    if (c == 0x29 /* ) */) {
+      if (open) {
+        kind |= FN;
+      }
+    }
+
+    else if (c == 0x28 /* ( */) {
+      if (prev >= 0 && is_decl_char(prev)) {
+        open = true;
+      }
+    }
+
+    else if (c == 0x7b /* { */) {
+      braces_open++;
+    }
+
+    else if (c == 0x7d /* } */) {
+      braces_close++;
+    }
+
+    else if (c == 0x3b /* ; */) {
+      if (semi < 0) {
+        semi = i;
+        kind |= SEMI;
+      }
+    }
+
+    else if (c == 0x2f /* / */) {
+      if (prev == 0x2a /* * */) {
+        kind |= BLOCK_CLOSE;
+      }
+    }
+
+    else if (is_space(c)) {
+      if (is_terminator(c)) {
+        open = false;
+      }
+
+      if (prev == 0x74 /* t */ && i >= 6 && ln.startsWith('struct', i - 6)) {
+        kind |= STRUCT;
+      }
+
+      else if (prev == 0x6d /* m */ && i >= 4 && ln.startsWith('enum', i - 4)) {
+        kind |= ENUM;
+      }
+    }
+
+    prev = c;
+  }
+
+  out.kind = kind;
+  out.open = braces_open;
+  out.close = braces_close;
+  out.semi = semi;
+  return out;
+}
+
+/**
+ * Shared result for one-off classification.
+ */
+const SCRATCH = new Scan();
+
+/**
+ * Classifies a line in one forward scan.
+ *
+ * @param {string} ln line to classify
+ * @return {number} bitmask of FN, STRUCT and ENUM
+ */
+function classify(ln) {
+  return scan(ln, SCRATCH).kind & (FN | STRUCT | ENUM);
+}
+
+module.exports = {
+  FN,
+  STRUCT,
+  ENUM,
+  BLOCK_OPEN,
+  BLOCK_CLOSE,
+  LINE_COMM,
+  SEMI,
+  Scan,
+  scan,
+  classify,
+};
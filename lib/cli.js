@@ -1,8 +1,7 @@
-const yargs = require('yargs/yargs');
 const logger = require('./utils').logger;
 
-const ast_from_file = require('./abstractor').ast_from_file;
-const annotate_file = require('./annotator').annotate_file;
+// The argument parser, abstractor and annotator are required lazily,
+// once a command needs them, to keep cold starts short.
 
 /**
  * CLI Log helper
@@ -24,24 +23,41 @@ function stop(code = 1) {
  * Will exit process upon completion or failure.
  */
 function exec() {
+    const argv = args();
+
+    // Plain `transform <input>` is served without the argument parser.
+    if (argv.length == 2 && argv[0] == 'transform' && argv[1][0] != '-') {
+        executed = true;
+        return transform({ input: argv[1] });
+    }
+
+    const yargs = require('yargs/yargs');
     const parser = yargs()
         .usage('$0 <cmd> [args]')
-          .command('transform <input> [--range]',
+          .command('transform <input> [--range] [--heap-report] [--output]',
                    'transform input into an AST json',
                    ...transform_command())
 
-          .command('annotate  <input> [--range] [--colorize]',
+          .command('annotate  <input> [--range] [--colorize] [--checkpoints]',
                    'annotate input with node metadata',
                    ...annotate_command())
+
+          .command('index     <dir> [--db]',
+                   'build or refresh the symbol index of a tree',
+                   ...index_command())
+
+          .command('lookup    <name> [--dir] [--db]',
+                   'find where a symbol is declared',
+                   ...lookup_command())
         .help()
 
     // Parse the cli arguments and execute commands.
-    const parsed = parser.parse(args());
+    const parsed = parser.parse(argv);
 
     // Detect no commands were executed and bring up the help.
     if (!executed) {
-        if (args().length > 0) {
-            log.error("Sorry, we couldn't recognize your arguments", args(), "\n")
+        if (argv.length > 0) {
+            log.error("Sorry, we couldn't recognize your arguments", argv, "\n")
         }
 
         parser.help().parse(["--help"])
@@ -53,32 +69,147 @@ function transform_command() {
         name: {
             default: 'transform',
             describe: 'file you wish to extract docs from'
+        },
+        only: {
+            type: 'string',
+            describe: 'node kinds to extract, eg. comments,defs'
+        },
+        index: {
+            type: 'boolean',
+            default: true,
+            describe: 'build the line index (--no-index to skip)'
+        },
+        members: {
+            type: 'boolean',
+            default: true,
+            describe: 'extract struct members (--no-members to skip)'
+        },
+        decl: {
+            type: 'boolean',
+            describe: 'decompose struct and enum member declarations'
+        },
+        'heap-report': {
+            type: 'boolean',
+            describe: 'print estimated memory use per container to stderr'
+        },
+        preprocess: {
+            type: 'boolean',
+            describe: 'skip preprocessor disabled regions'
+        },
+        define: {
+            type: 'array',
+            alias: 'D',
+            describe: 'macros taken as defined, implies --preprocess'
+        },
+        undef: {
+            type: 'array',
+            alias: 'U',
+            describe: 'macros taken as undefined, implies --preprocess'
+        },
+        range: {
+            type: 'string',
+            describe: 'only parse the nodes enclosing lines, eg. 9000,9050'
+        },
+        checkpoints: {
+            type: 'number',
+            describe: 'write parser checkpoints every N lines next to the input'
+        },
+        'comment-index': {
+            type: 'string',
+            describe: 'write a trigram index of comment text to a file'
+        },
+        compact: {
+            type: 'boolean',
+            describe: 'print the AST json without whitespace'
+        },
+        output: {
+            type: 'string',
+            alias: 'o',
+            describe: 'write the AST json to a file, compressed when ' +
+                'named *.gz or *.br'
         }
     }, (argv) => {
         executed = true;
+        transform(argv);
+    }];
+}
 
-        if (!argv.input) {
-            console.error(
-                "\nFile [input] needs to be specified\n")
-        } else {
-            let process = ast_from_file(argv.input)
-                .then((result) => {
-                    if (result && result.code) {
-                        console.log(result.json());
-                    } else {
-                        stop();
-                    }
-
-                })
-                .catch((err) => {
-                    log.error(
-                        "Failed to process your input", err);
-                    stop();
-                });
+/**
+ * Transforms the input file, printing the AST json to stdout or writing
+ * it to the output file. Compressed input is detected and decompressed.
+ * @param {object} argv parsed arguments
+ */
+function transform(argv) {
+    if (!argv.input) {
+        console.error(
+            "\nFile [input] needs to be specified\n")
+        return;
+    }
 
-            return;
-        }
-    }];
+    const opts = {
+        only: argv.only,
+        index: argv.index,
+        members: argv.members,
+        decl: argv.decl,
+        preprocess: argv.preprocess,
+        defines: argv.define,
+        undefines: argv.undef,
+        checkpoints: argv.checkpoints,
+        search: !!argv['comment-index'],
+        memory: !!argv['heap-report']
+    };
+
+    let generated;
+    if (argv.range !== undefined || argv.checkpoints) {
+        const checkpoint = require('./checkpoint');
+        generated = new Promise((resolve) => resolve(argv.range !== undefined ?
+            checkpoint.range(argv.input, ...checkpoint.bounds(argv.range), opts) :
+            checkpoint.build(argv.input, opts)));
+    } else {
+        generated = require('./abstractor').ast_from_file(argv.input, opts);
+    }
+
+    generated
+        .then((result) => {
+            if (!result || !result.code) {
+                stop();
+                return;
+            }
+
+            const json = result.json({ compact: argv.compact });
+            const written = argv.output ? write(argv.output, json) :
+                console.log(json);
+
+            if (argv['comment-index']) {
+                require('./search').save(result.search,
+                    argv['comment-index']);
+            }
+
+            if (argv['heap-report']) {
+                const memory = require('./memory');
+                console.error(memory.format(result.memoryStats()));
+            }
+
+            return written;
+        })
+        .catch((err) => {
+            log.error(
+                "Failed to process your input", err);
+            stop();
+        });
+}
+
+/**
+ * Writes the AST json to a file, compressing it on the fly by the file
+ * extension.
+ * @param {string} file output path
+ * @param {string} json
+ * @return {Promise} resolved once the file is written
+ */
+function write(file, json) {
+    const out = require('./compression').writer(file);
+    out.stream.end(json + '\n');
+    return out.done;
 }
 
 function annotate_command() {
@@ -93,10 +224,72 @@ function annotate_command() {
             console.error(
                 "\nFile <input> needs to be specified\n")
         } else {
+            const annotate_file = require('./annotator').annotate_file;
             annotate_file(argv.input, {
                 range: argv.range,
-                colorize: argv.colorize
+                colorize: argv.colorize,
+                checkpoints: argv.checkpoints
+            })
+                .catch((err) => {
+                    log.error("Failed to annotate your input", err);
+                    stop();
+                });
+        }
+    }];
+}
+
+function index_command() {
+    return [{
+        db: {
+            type: 'string',
+            describe: 'symbol index file, defaults to <dir>/.c-ast-index.json'
+        }
+    }, (argv) => {
+        executed = true;
+        const symbols = require('./symbols');
+
+        symbols.build(argv.dir, { db: argv.db })
+            .then((stats) => {
+                console.log(
+                    `Indexed ${stats.files} files: ${stats.parsed} parsed, ` +
+                    `${stats.reused} unchanged, ${stats.removed} removed, ` +
+                    `${stats.symbols} symbols`);
+            })
+            .catch((err) => {
+                log.error("Failed to index your tree", err);
+                stop();
             });
+    }];
+}
+
+function lookup_command() {
+    return [{
+        dir: {
+            type: 'string',
+            default: '.',
+            describe: 'indexed tree'
+        },
+        db: {
+            type: 'string',
+            describe: 'symbol index file, defaults to <dir>/.c-ast-index.json'
+        }
+    }, (argv) => {
+        executed = true;
+        const path = require('path');
+        const symbols = require('./symbols');
+        const matches = symbols.lookup(String(argv.name), {
+            dir: argv.dir,
+            db: argv.db
+        });
+
+        if (!matches.length) {
+            stop();
+            return;
+        }
+
+        for (const sym of matches) {
+            console.log(`${path.relative('.', sym.file)}:${sym.start + 1}: ` +
+                `${sym.kind} ${sym.name}`);
         }
     }];
 }
@@ -0,0 +1,138 @@
+/**
+ * @fileOverview
+ * Transparent compression of input and output files.
+ *
+ * Gzip input is recognized by its magic bytes, whatever the file is
+ * named. Brotli streams start with no magic number, so brotli input is
+ * recognized by a `.br` extension. Compressed input is decompressed as
+ * it is read, ahead of line splitting, with no temporary file. Output
+ * files are compressed on the fly according to their extension, `.gz`
+ * or `.br`, and written as is otherwise.
+ *
+ * @name compression.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const zlib = require('zlib');
+const pipeline = require('stream').pipeline;
+
+const GZIP = 'gzip';
+const BROTLI = 'brotli';
+
+const GZIP_MAGIC = [0x1f, 0x8b];
+
+/**
+ * Format of an output path, by extension.
+ *
+ * @param {string} file path
+ * @return {string|null} GZIP, BROTLI or null for plain files
+ */
+function format_of(file) {
+  if (file.endsWith('.gz')) {
+    return GZIP;
+  }
+  if (file.endsWith('.br')) {
+    return BROTLI;
+  }
+  return null;
+}
+
+/**
+ * Format of an input file, from its leading bytes, or its extension for
+ * brotli.
+ *
+ * @param {string} file path
+ * @return {string|null} GZIP, BROTLI or null for plain files
+ */
+function detect(file) {
+  const head = Buffer.alloc(GZIP_MAGIC.length);
+  const fd = fs.openSync(file, 'r');
+  let read;
+  try {
+    read = fs.readSync(fd, head, 0, head.length, 0);
+  } finally {
+    fs.closeSync(fd);
+  }
+
+  if (read == GZIP_MAGIC.length && head[0] == GZIP_MAGIC[0] &&
+    head[1] == GZIP_MAGIC[1]) {
+    return GZIP;
+  }
+  return format_of(file) == BROTLI ? BROTLI : null;
+}
+
+function decompressor(format) {
+  return format == GZIP ? zlib.createGunzip() : zlib.createBrotliDecompress();
+}
+
+function compressor(format) {
+  return format == GZIP ? zlib.createGzip() : zlib.createBrotliCompress();
+}
+
+/**
+ * Readable stream of the decompressed content of a file.
+ * Read and decompression errors are emitted by the returned stream.
+ *
+ * @param {string} file path
+ * @return {Readable}
+ */
+function reader(file) {
+  const format = detect(file);
+  const input = fs.createReadStream(file);
+  return format ? pipeline(input, decompressor(format), () => {}) : input;
+}
+
+/**
+ * Decompressed content of a compressed file, read at once.
+ *
+ * @param {string} file path
+ * @return {Buffer|null} null for plain files, which may be read as is
+ */
+function read_sync(file) {
+  const format = detect(file);
+  if (!format) {
+    return null;
+  }
+
+  const data = fs.readFileSync(file);
+  return format == GZIP ? zlib.gunzipSync(data) :
+    zlib.brotliDecompressSync(data);
+}
+
+/**
+ * Writable stream to a file, compressing what is written by the file's
+ * extension.
+ *
+ * @param {string} file path
+ * @return {object} { stream, done }, done resolving once the file is
+ *   fully written and rejecting on any write or compression error.
+ */
+function writer(file) {
+  const format = format_of(file);
+  const output = fs.createWriteStream(file);
+
+  if (!format) {
+    const done = new Promise((resolve, reject) => {
+      output.on('finish', resolve);
+      output.on('error', reject);
+    });
+    return { stream: output, done };
+  }
+
+  const stream = compressor(format);
+  const done = new Promise((resolve, reject) => {
+    pipeline(stream, output, (err) => err ? reject(err) : resolve());
+  });
+  return { stream, done };
+}
+
+module.exports = {
+  GZIP,
+  BROTLI,
+  detect,
+  reader,
+  read_sync,
+  writer,
+};
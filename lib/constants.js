@@ -7,6 +7,22 @@ const DEF = 'defs';
 const NA = 'na';
 const SKIP = 'skip';
 
+/**
+ * Integer tags for each node type, used in hot comparisons.
+ */
+const TAG = {
+    [COMM]: 0,
+    [CODE]: 1,
+    [DEF]: 2,
+    [MEMB]: 3,
+    [CHAR]: 4,
+    [SKIP]: 5,
+};
+
+/**
+ * Node types ordered by their integer tag.
+ */
+const TYPES = [COMM, CODE, DEF, MEMB, CHAR, SKIP];
 
 module.exports = {
     CHAR,
@@ -15,5 +31,7 @@ module.exports = {
     MEMB,
     DEF,
     NA,
-    SKIP
-}
\ No newline at end of file
+    SKIP,
+    TAG,
+    TYPES
+}
@@ -0,0 +1,325 @@
+/**
+ * @fileOverview
+ * Member declaration decomposition.
+ *
+ * Struct and union members are broken down into their qualifiers, type,
+ * pointer depth, name, array dimensions and bitfield width, with the type
+ * name interned into the AST's type table. Enum members are broken down
+ * into their name and value.
+ *
+ * Comma separated plain declarators sharing the type of the first, such
+ * as `float x, y;`, are listed as names of a single declaration. Lists in
+ * which a declarator has a pointer, array or bitfield part of its own, and
+ * pointers qualified past their `*`, such as `char *const p;`, are left
+ * undecomposed, as are other lines such as nested blocks.
+ *
+ * @name decl.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+/**
+ * Qualifier bits.
+ */
+const QUAL = {
+  const: 1,
+  volatile: 2,
+  restrict: 4,
+  static: 8,
+  extern: 16,
+  register: 32,
+};
+
+// Trailing parts of a declaration are found by scanning, as unanchored
+// patterns backtrack over every long run of spaces or word characters.
+const COMMENT_RE = /\/\*.*?(\*\/|$)|\/\/.*$/g;
+const REJECT_RE = /[{},#=]/;
+const LIST_RE = /^([^,]*?\w)\s*((?:,\s*\w+\s*)+)$/;
+const DECLARATOR_RE = /[*[\]:]/;
+
+/**
+ * Decomposed member declaration.
+ * Fields not applicable to the member stay undefined, and are omitted
+ * from JSON output.
+ */
+class Decl {
+  /**
+   * @param {string} name declared name
+   */
+  constructor(name) {
+    this.name = name;
+    this.names = undefined;
+    this.type = undefined;
+    this.quals = undefined;
+    this.ptr = undefined;
+    this.dims = undefined;
+    this.bits = undefined;
+    this.value = undefined;
+  }
+}
+
+const is_word = (c) => c == 95 || (c >= 48 && c <= 57) ||
+  (c >= 65 && c <= 90) || (c >= 97 && c <= 122);
+const is_space = (c) => c == 32 || (c >= 9 && c <= 13);
+
+/**
+ * End of the run of characters matching a test, from a position.
+ */
+function skip(str, pos, test) {
+  while (pos < str.length && test(str.charCodeAt(pos))) {
+    pos++;
+  }
+  return pos;
+}
+
+/**
+ * Start of the run of characters matching a test, ending at a position.
+ */
+function skip_back(str, end, test) {
+  while (end > 0 && test(str.charCodeAt(end - 1))) {
+    end--;
+  }
+  return end;
+}
+
+/**
+ * Collapses whitespace, and spaces out pointer stars.
+ */
+function squash(str) {
+  return str.replace(/\s+/g, ' ').replace(/ ?\* ?/g, ' *').trim();
+}
+
+/**
+ * Splits a function pointer member, `ret (*name)(args)`.
+ *
+ * @param {string} ln member, without its semicolon
+ * @return {array|null} [ret, name, args]
+ */
+function fn_ptr(ln) {
+  if (ln[ln.length - 1] != ')') {
+    return null;
+  }
+
+  for (let paren = ln.indexOf('(', 1); paren >= 0;
+    paren = ln.indexOf('(', paren + 1)) {
+    let pos = skip(ln, paren + 1, is_space);
+    if (ln[pos] != '*') {
+      continue;
+    }
+    const name = skip(ln, pos + 1, is_space);
+    pos = skip(ln, name, is_word);
+    if (pos == name) {
+      continue;
+    }
+    const end = pos;
+    pos = skip(ln, pos, is_space);
+    if (ln[pos] != ')') {
+      continue;
+    }
+    pos = skip(ln, pos + 1, is_space);
+    if (ln[pos] != '(') {
+      continue;
+    }
+    return [ln.slice(0, paren), ln.slice(name, end), ln.slice(pos + 1, -1)];
+  }
+  return null;
+}
+
+/**
+ * Decomposes an enum member.
+ *
+ * @param {string} ln member line, without comments
+ * @return {Decl|undefined}
+ */
+function enumerator(ln) {
+  const name = skip(ln, 0, is_word);
+  if (!name) {
+    return;
+  }
+
+  const decl = new Decl(ln.slice(0, name));
+  let pos = skip(ln, name, is_space);
+
+  if (ln[pos] == '=') {
+    pos = skip(ln, pos + 1, is_space);
+    let end = ln.length;
+    if (end - pos > 1 && ln[end - 1] == ',') {
+      end--;
+    }
+    end = Math.max(pos + 1, skip_back(ln, end, is_space));
+    if (end > ln.length) {
+      return;
+    }
+    decl.value = ln.slice(pos, end);
+  } else if (pos < ln.length && !(pos == ln.length - 1 && ln[pos] == ',')) {
+    return;
+  }
+  return decl;
+}
+
+/**
+ * Decomposes a struct or union member.
+ *
+ * @param {string} ln member line, without comments
+ * @param {TypeTable} types dictionary the type name is interned into
+ * @return {Decl|undefined}
+ */
+function member(ln, types) {
+  if (ln[ln.length - 1] != ';') {
+    return;
+  }
+  ln = ln.slice(0, -1).trim();
+
+  let m = fn_ptr(ln);
+  if (m) {
+    if (REJECT_RE.test(m[0])) {
+      return;
+    }
+    const decl = new Decl(m[1]);
+    decl.type = types.intern(`${squash(m[0])} (*)(${squash(m[2])})`);
+    decl.quals = 0;
+    decl.ptr = 0;
+    return decl;
+  }
+
+  // Further declarators of the same type
+  let names;
+  m = LIST_RE.exec(ln);
+  if (m) {
+    // Parts of the first declarator would not apply to the others
+    if (DECLARATOR_RE.test(m[1])) {
+      return;
+    }
+    ln = m[1];
+    names = m[2].split(',').slice(1).map((name) => name.trim());
+  }
+
+  if (REJECT_RE.test(ln)) {
+    return;
+  }
+
+  // Bitfield width, `: 3`
+  let bits;
+  let end = ln.length;
+  let start = skip_back(ln, end, is_word);
+  if (start < end) {
+    const colon = skip_back(ln, start, is_space) - 1;
+    if (ln[colon] == ':') {
+      bits = ln.slice(start, end);
+      bits = /^\d+$/.test(bits) ? Number(bits) : bits;
+      ln = ln.slice(0, skip_back(ln, colon, is_space));
+    }
+  }
+
+  // Array dimensions, `[4][N]`
+  let dims;
+  end = ln.length;
+  while (ln[end - 1] == ']') {
+    const open = ln.indexOf('[', ln.lastIndexOf(']', end - 2) + 1);
+    if (open < 0 || open >= end) {
+      break;
+    }
+    dims = dims || [];
+    dims.push(ln.slice(open + 1, end - 1).trim());
+    end = skip_back(ln, open, is_space);
+  }
+  if (dims) {
+    dims.reverse();
+    ln = ln.slice(0, end);
+  }
+
+  start = skip_back(ln, ln.length, is_word);
+  if (start == ln.length) {
+    return;
+  }
+  const name = ln.slice(start);
+
+  let quals = 0;
+  let ptr = 0;
+  const base = [];
+  for (const token of ln.slice(0, start).split(/(\*)|\s+/)) {
+    if (!token) {
+      continue;
+    }
+    if (token == '*') {
+      ptr++;
+    } else if (QUAL.hasOwnProperty(token)) {
+      // Qualifiers of the pointer itself are not recorded
+      if (ptr) {
+        return;
+      }
+      quals |= QUAL[token];
+    } else {
+      base.push(token);
+    }
+  }
+
+  if (!base.length) {
+    return;
+  }
+
+  const decl = new Decl(name);
+  if (names) {
+    decl.names = [name].concat(names);
+  }
+  decl.type = types.intern(base.join(' '));
+  decl.quals = quals;
+  decl.ptr = ptr;
+  decl.dims = dims;
+  decl.bits = bits;
+  return decl;
+}
+
+/**
+ * Decomposes a member line.
+ *
+ * @param {string} line raw member line
+ * @param {TypeTable} types dictionary type names are interned into
+ * @param {boolean} is_enum whether the line belongs to an enum
+ * @return {Decl|undefined}
+ */
+function parse(line, types, is_enum) {
+  const ln = line.replace(COMMENT_RE, '').trim();
+  if (!ln) {
+    return;
+  }
+  return is_enum ? enumerator(ln) : member(ln, types);
+}
+
+/**
+ * Shares the identifiers of a declaration through an intern pool.
+ *
+ * @param {Decl|undefined} decl
+ * @param {Lease} strings references of the AST, see intern.js
+ * @return {Decl|undefined} decl
+ */
+function intern(decl, strings) {
+  if (decl) {
+    decl.name = strings.intern(decl.name);
+    if (decl.names) {
+      decl.names = decl.names.map((name) => strings.intern(name));
+    }
+    if (decl.value !== undefined) {
+      decl.value = strings.intern(decl.value);
+    }
+  }
+  return decl;
+}
+
+/**
+ * Names of the qualifier bits set in a mask.
+ *
+ * @param {number} quals qualifier bits
+ * @return {array}
+ */
+function qualifiers(quals) {
+  return Object.keys(QUAL).filter((name) => quals & QUAL[name]);
+}
+
+module.exports = {
+  QUAL,
+  Decl,
+  parse,
+  intern,
+  qualifiers,
+};
@@ -0,0 +1,319 @@
+/**
+ * @fileOverview
+ * Persistent hash array mapped trie.
+ *
+ * An immutable string keyed map: updates return a new map sharing every
+ * untouched branch with the previous one, copying only the path from the
+ * root to the changed entry. Trie nodes are frozen once built.
+ *
+ * @name hamt.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+/**
+ * Branching factor of 32, consuming 5 bits of hash per level.
+ */
+const BITS = 5;
+const MASK = (1 << BITS) - 1;
+
+/**
+ * 32-bit FNV-1a hash of a string key.
+ *
+ * @param {string} key
+ * @return {number} unsigned hash
+ */
+function hash(key) {
+  let h = 0x811c9dc5;
+  for (let i = 0; i < key.length; i++) {
+    h ^= key.charCodeAt(i);
+    h = Math.imul(h, 0x01000193);
+  }
+  return h >>> 0;
+}
+
+/**
+ * Number of set bits.
+ *
+ * @param {number} x 32-bit integer
+ * @return {number}
+ */
+function popcount(x) {
+  x -= (x >> 1) & 0x55555555;
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  return (((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >>> 24;
+}
+
+class Leaf {
+  constructor(h, key, value) {
+    this.hash = h;
+    this.key = key;
+    this.value = value;
+    Object.freeze(this);
+  }
+}
+
+class Collision {
+  constructor(h, leaves) {
+    this.hash = h;
+    this.leaves = Object.freeze(leaves);
+    Object.freeze(this);
+  }
+}
+
+class Branch {
+  constructor(bitmap, children) {
+    this.bitmap = bitmap;
+    this.children = Object.freeze(children);
+    Object.freeze(this);
+  }
+}
+
+/**
+ * Builds the smallest branch holding two entries of differing hashes.
+ */
+function merge(a, b, shift) {
+  const ai = (a.hash >>> shift) & MASK;
+  const bi = (b.hash >>> shift) & MASK;
+
+  if (ai == bi) {
+    return new Branch(1 << ai, [merge(a, b, shift + BITS)]);
+  }
+
+  return new Branch((1 << ai) | (1 << bi), ai < bi ? [a, b] : [b, a]);
+}
+
+function lookup(node, shift, h, key) {
+  while (node) {
+    if (node instanceof Branch) {
+      const bit = 1 << ((h >>> shift) & MASK);
+      if (!(node.bitmap & bit)) {
+        return undefined;
+      }
+      node = node.children[popcount(node.bitmap & (bit - 1))];
+      shift += BITS;
+    }
+
+    else if (node instanceof Leaf) {
+      return node.key === key ? node : undefined;
+    }
+
+    else {
+      return node.leaves.find((l) => l.key === key);
+    }
+  }
+}
+
+/**
+ * Returns the updated trie, or the same node when nothing changed.
+ */
+function insert(node, shift, leaf, added) {
+  if (!node) {
+    added.value = true;
+    return leaf;
+  }
+
+  if (node instanceof Leaf) {
+    if (node.key === leaf.key) {
+      return node.value === leaf.value ? node : leaf;
+    }
+
+    added.value = true;
+    if (node.hash === leaf.hash) {
+      return new Collision(leaf.hash, [node, leaf]);
+    }
+    return merge(node, leaf, shift);
+  }
+
+  if (node instanceof Collision) {
+    if (node.hash !== leaf.hash) {
+      added.value = true;
+      return merge(node, leaf, shift);
+    }
+
+    const i = node.leaves.findIndex((l) => l.key === leaf.key);
+    if (i < 0) {
+      added.value = true;
+      return new Collision(leaf.hash, node.leaves.concat([leaf]));
+    }
+    if (node.leaves[i].value === leaf.value) {
+      return node;
+    }
+
+    const leaves = node.leaves.slice();
+    leaves[i] = leaf;
+    return new Collision(leaf.hash, leaves);
+  }
+
+  const bit = 1 << ((leaf.hash >>> shift) & MASK);
+  const idx = popcount(node.bitmap & (bit - 1));
+
+  if (!(node.bitmap & bit)) {
+    added.value = true;
+    const children = node.children.slice();
+    children.splice(idx, 0, leaf);
+    return new Branch(node.bitmap | bit, children);
+  }
+
+  const child = node.children[idx];
+  const next = insert(child, shift + BITS, leaf, added);
+  if (next === child) {
+    return node;
+  }
+
+  const children = node.children.slice();
+  children[idx] = next;
+  return new Branch(node.bitmap, children);
+}
+
+/**
+ * Returns the trie without the key: null once emptied, or the same
+ * node when the key was absent.
+ */
+function remove(node, shift, h, key) {
+  if (node instanceof Leaf) {
+    return node.key === key ? null : node;
+  }
+
+  if (node instanceof Collision) {
+    const leaves = node.leaves.filter((l) => l.key !== key);
+    if (leaves.length == node.leaves.length) {
+      return node;
+    }
+    return leaves.length == 1 ? leaves[0] : new Collision(node.hash, leaves);
+  }
+
+  const bit = 1 << ((h >>> shift) & MASK);
+  if (!(node.bitmap & bit)) {
+    return node;
+  }
+
+  const idx = popcount(node.bitmap & (bit - 1));
+  const child = node.children[idx];
+  const next = remove(child, shift + BITS, h, key);
+
+  if (next === child) {
+    return node;
+  }
+
+  if (next) {
+    // Lift lone entries, which are found by key at any depth
+    if (node.children.length == 1 && !(next instanceof Branch)) {
+      return next;
+    }
+
+    const children = node.children.slice();
+    children[idx] = next;
+    return new Branch(node.bitmap, children);
+  }
+
+  if (node.children.length == 1) {
+    return null;
+  }
+
+  const children = node.children.slice();
+  children.splice(idx, 1);
+  if (children.length == 1 && !(children[0] instanceof Branch)) {
+    return children[0];
+  }
+  return new Branch(node.bitmap & ~bit, children);
+}
+
+function* walk(node) {
+  if (!node) {
+    return;
+  }
+
+  if (node instanceof Leaf) {
+    yield node;
+  } else if (node instanceof Collision) {
+    yield* node.leaves;
+  } else {
+    for (const child of node.children) {
+      yield* walk(child);
+    }
+  }
+}
+
+/**
+ * Immutable map of string keys.
+ */
+class PersistentMap {
+  constructor(root = null, size = 0) {
+    this.root = root;
+    this.size = size;
+    Object.freeze(this);
+  }
+
+  get(key) {
+    key = String(key);
+    const leaf = lookup(this.root, 0, hash(key), key);
+    return leaf ? leaf.value : undefined;
+  }
+
+  has(key) {
+    key = String(key);
+    return lookup(this.root, 0, hash(key), key) !== undefined;
+  }
+
+  /**
+   * @return {PersistentMap} updated map, or this map when unchanged.
+   */
+  set(key, value) {
+    key = String(key);
+    const added = { value: false };
+    const root = insert(this.root, 0, new Leaf(hash(key), key, value), added);
+
+    if (root === this.root) {
+      return this;
+    }
+    return new PersistentMap(root, this.size + (added.value ? 1 : 0));
+  }
+
+  /**
+   * @return {PersistentMap} updated map, or this map when unchanged.
+   */
+  delete(key) {
+    key = String(key);
+    if (!this.root) {
+      return this;
+    }
+
+    const root = remove(this.root, 0, hash(key), key);
+    if (root === this.root) {
+      return this;
+    }
+    return root ? new PersistentMap(root, this.size - 1) : EMPTY;
+  }
+
+  * keys() {
+    for (const leaf of walk(this.root)) {
+      yield leaf.key;
+    }
+  }
+
+  * values() {
+    for (const leaf of walk(this.root)) {
+      yield leaf.value;
+    }
+  }
+
+  * entries() {
+    for (const leaf of walk(this.root)) {
+      yield [leaf.key, leaf.value];
+    }
+  }
+
+  [Symbol.iterator]() {
+    return this.entries();
+  }
+}
+
+const EMPTY = new PersistentMap();
+
+PersistentMap.empty = () => EMPTY;
+
+module.exports = {
+  PersistentMap,
+  hash,
+};
@@ -0,0 +1,194 @@
+/**
+ * @fileOverview
+ * Cross-file string interning for batch runs.
+ *
+ * ASTs parsed with the same InternPool, passed as the `intern` generation
+ * option, share a single copy of every identical source line and member
+ * identifier: license banners, include guards, braces and common
+ * declarations are held once for the whole batch instead of once per
+ * file. Strings are looked up by their hash, which V8 computes once and
+ * caches on each string.
+ *
+ * Each AST holds a reference to every string it interned: its source
+ * lines, which `ast.source` already lists, and the identifiers and inner
+ * comment fragments listed by its lease. Releasing the AST drops its
+ * references, and strings no AST refers to any more leave the pool, so
+ * that long batches only retain the strings of live ASTs.
+ *
+ * @name intern.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+/**
+ * Copy of a string owning its characters. Lines read from a stream are
+ * slices of the chunk they were read from, and would keep the whole
+ * chunk alive for as long as they are pooled.
+ *
+ * Decoding is how lines and shared regions are read too, and yields the
+ * most compact copy. Lone surrogates do not survive UTF-8: such strings
+ * get a character prepended instead, flattened by the slice into a
+ * string of their own that the copy refers to.
+ */
+function own(str) {
+  const copy = Buffer.from(str, 'utf8').toString('utf8');
+  return copy === str ? copy : (' ' + str).slice(1);
+}
+
+/**
+ * References held by a single AST, other than its source lines.
+ */
+class Lease {
+  /**
+   * @param {InternPool} pool
+   */
+  constructor(pool) {
+    this.pool = pool;
+    this.held = [];
+  }
+
+  /**
+   * Interns a source line, referenced through `ast.source`.
+   *
+   * @param {string} str
+   * @return {string} the pooled copy
+   */
+  line(str) {
+    return this.pool.intern(str);
+  }
+
+  /**
+   * Interns any other string of the AST.
+   *
+   * @param {string} str
+   * @return {string} the pooled copy
+   */
+  intern(str) {
+    const pooled = this.pool.intern(str);
+    this.held.push(pooled);
+    return pooled;
+  }
+}
+
+/**
+ * Reference counted string pool.
+ * Strings are kept in slots, reused once their last reference is gone.
+ */
+class InternPool {
+  constructor() {
+    this.slots = new Map();   // string => slot
+    this.strings = [];        // slot => pooled string
+    this.refs = [];           // slot => reference count
+    this.vacant = [];         // released slots
+    this.hits = 0;
+    this.misses = 0;
+  }
+
+  /**
+   * Number of distinct strings pooled.
+   * @return {number}
+   */
+  get size() {
+    return this.slots.size;
+  }
+
+  /**
+   * References to a string, taking one more.
+   *
+   * @param {string} str
+   * @return {string} the pooled copy, shared by every caller
+   */
+  intern(str) {
+    let slot = this.slots.get(str);
+
+    if (slot === undefined) {
+      this.misses++;
+      str = own(str);
+      slot = this.vacant.length ? this.vacant.pop() : this.strings.length;
+      this.slots.set(str, slot);
+      this.strings[slot] = str;
+      this.refs[slot] = 1;
+      return str;
+    }
+
+    this.hits++;
+    this.refs[slot]++;
+    return this.strings[slot];
+  }
+
+  /**
+   * Drops a reference to a string, removing it from the pool along with
+   * its last reference.
+   *
+   * @param {string} str
+   */
+  unref(str) {
+    const slot = this.slots.get(str);
+    if (slot === undefined) {
+      return;
+    }
+
+    if (--this.refs[slot] == 0) {
+      this.slots.delete(str);
+      this.strings[slot] = undefined;
+      this.vacant.push(slot);
+    }
+  }
+
+  /**
+   * Number of references to a string.
+   *
+   * @param {string} str
+   * @return {number} 0 when not pooled
+   */
+  count(str) {
+    const slot = this.slots.get(str);
+    return slot === undefined ? 0 : this.refs[slot];
+  }
+
+  /**
+   * References of a new AST.
+   * @return {Lease}
+   */
+  lease() {
+    return new Lease(this);
+  }
+
+  /**
+   * Drops every reference held by an AST. The AST keeps its strings,
+   * and may still be used, but no longer keeps them pooled.
+   *
+   * @param {object} ast tree generated with this pool, with its source
+   *   lines untouched
+   */
+  release(ast) {
+    const lease = ast.strings;
+    if (!lease || lease.pool !== this) {
+      return;
+    }
+
+    for (let i = 0; i < ast.source.length; i++) {
+      this.unref(ast.source[i]);
+    }
+    for (let i = 0; i < lease.held.length; i++) {
+      this.unref(lease.held[i]);
+    }
+    ast.strings = null;
+  }
+
+  /**
+   * Pool counters.
+   * @return {object}
+   */
+  stats() {
+    return {
+      size: this.size,
+      hits: this.hits,
+      misses: this.misses,
+    };
+  }
+}
+
+module.exports = {
+  InternPool,
+};
@@ -0,0 +1,125 @@
+/**
+ * @fileOverview
+ * Byte offset aware line splitter.
+ *
+ * Reads a file from any byte offset and hands out its lines along with
+ * the offset each starts at, so that a parse can later resume from the
+ * middle of a file. Lines break on `\n`, with a preceding `\r` dropped,
+ * matching the lines emitted by readline for LF and CRLF files.
+ *
+ * Compressed files cannot be read from an offset, and are decompressed
+ * at once instead; their offsets are those of the decompressed bytes.
+ *
+ * @name lines.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const compression = require('./compression');
+
+/**
+ * Bytes read from the file at once.
+ */
+const CHUNK = 64 * 1024;
+
+const LF = 0x0a;
+const CR = 0x0d;
+
+/**
+ * Calls fn for each line of a file, starting at a byte offset.
+ *
+ * @param {string} file path
+ * @param {number} offset byte offset of the first line
+ * @param {function} fn called with the line text and its byte offset,
+ *   returning false to stop reading.
+ * @return {number} offset past the last line read
+ */
+function each(file, offset, fn) {
+  const data = compression.read_sync(file);
+  if (data) {
+    return each_buffer(data, offset, fn);
+  }
+
+  const fd = fs.openSync(file, 'r');
+  let chunk = Buffer.allocUnsafe(CHUNK);
+  let pending = 0;   // bytes of a partial line at the start of chunk
+  let pos = offset;  // file offset of chunk[0]
+
+  try {
+    for (;;) {
+      if (pending == chunk.length) {
+        // Line longer than the chunk
+        const grown = Buffer.allocUnsafe(chunk.length * 2);
+        chunk.copy(grown, 0, 0, pending);
+        chunk = grown;
+      }
+
+      const read = fs.readSync(fd, chunk, pending, chunk.length - pending,
+        pos + pending);
+      const end = pending + read;
+      let start = 0;
+
+      if (!read) {
+        // Last line, without a trailing newline
+        if (end > 0) {
+          fn(text(chunk, 0, end), pos);
+        }
+        return pos + end;
+      }
+
+      let lf = chunk.indexOf(LF, pending);
+      while (lf >= 0 && lf < end) {
+        if (fn(text(chunk, start, lf), pos + start) === false) {
+          return pos + lf + 1;
+        }
+        start = lf + 1;
+        lf = chunk.indexOf(LF, start);
+      }
+
+      // Carry the partial line over
+      chunk.copy(chunk, 0, start, end);
+      pending = end - start;
+      pos += start;
+    }
+  } finally {
+    fs.closeSync(fd);
+  }
+}
+
+/**
+ * Calls fn for each line of a buffer, starting at a byte offset.
+ * See each.
+ */
+function each_buffer(buf, offset, fn) {
+  let start = offset;
+  let lf = buf.indexOf(LF, start);
+
+  while (lf >= 0) {
+    if (fn(text(buf, start, lf), start) === false) {
+      return lf + 1;
+    }
+    start = lf + 1;
+    lf = buf.indexOf(LF, start);
+  }
+
+  // Last line, without a trailing newline
+  if (start < buf.length) {
+    fn(text(buf, start, buf.length), start);
+  }
+  return buf.length;
+}
+
+/**
+ * Decodes a line, without its carriage return.
+ */
+function text(buf, start, end) {
+  if (end > start && buf[end - 1] == CR) {
+    end--;
+  }
+  return buf.toString('utf8', start, end);
+}
+
+module.exports = {
+  each,
+};
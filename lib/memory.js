@@ -0,0 +1,312 @@
+/**
+ * @fileOverview
+ * Memory accounting of generated ASTs.
+ *
+ * Retained bytes are estimated per container from the V8 object layout
+ * of a 64-bit build, while the peak process and heap sizes are sampled
+ * as lines are parsed.
+ *
+ * Line text is shared between `ast.source` and the node data maps, so
+ * it is attributed to the source only. Strings created by the parser,
+ * such as extracted inner comments, count towards their own container.
+ *
+ * @name memory.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const v8 = require('v8');
+const C = require('./constants');
+
+/**
+ * Estimated V8 layout sizes, in bytes.
+ */
+const WORD = 8;
+const HEADER = 3 * WORD;         // map, properties and elements
+const ARRAY = HEADER + WORD;     // plus length
+const STORE = 2 * WORD;          // backing store map and length
+const ENTRY = 3 * WORD;          // dictionary key, value and details
+const STRING = 2 * WORD;         // map, hash and length
+
+/**
+ * Lines parsed in between samples of the heap.
+ */
+const SAMPLE_LINES = 4096;
+
+/**
+ * Containers reported, in order.
+ */
+const CONTAINERS = [C.COMM, C.CODE, C.DEF, C.CHAR, C.SKIP, C.MEMB, 'types',
+  'search', 'index', 'source'];
+
+/**
+ * Creates an empty peak usage record.
+ * @return {object}
+ */
+function create_peak() {
+  return { rss: 0, heap: 0, samples: 0 };
+}
+
+/**
+ * Records current process and heap usage into a peak record.
+ *
+ * @param {object} peak record to be updated
+ */
+function sample(peak) {
+  const heap = v8.getHeapStatistics().used_heap_size;
+  const rss = process.memoryUsage.rss();
+
+  if (heap > peak.heap) peak.heap = heap;
+  if (rss > peak.rss) peak.rss = rss;
+  peak.samples++;
+}
+
+/**
+ * Estimated size of a string.
+ *
+ * @param {string} str
+ * @return {number} bytes
+ */
+function string(str) {
+  let wide = false;
+  for (let i = 0; i < str.length && !wide; i++) {
+    wide = str.charCodeAt(i) > 0xff;
+  }
+
+  const bytes = STRING + str.length * (wide ? 2 : 1);
+  return Math.ceil(bytes / WORD) * WORD;
+}
+
+/**
+ * Estimated size of an array of values.
+ */
+function array(length) {
+  return ARRAY + STORE + length * WORD;
+}
+
+/**
+ * Estimated size of a keyed map.
+ */
+function dict(entries) {
+  return HEADER + STORE + entries * ENTRY;
+}
+
+/**
+ * Running count and size of a container.
+ */
+function create_usage() {
+  return { count: 0, bytes: 0 };
+}
+
+/**
+ * Estimates the bytes retained by a single node, excluding members.
+ *
+ * @param {object} ast tree the node belongs to
+ * @param {Node} node to measure
+ * @return {number} bytes
+ */
+function node_bytes(ast, node) {
+  // Fixed shape: id, type, assocs, data, parent, inner, index, decl
+  let bytes = HEADER + 8 * WORD;
+
+  let types = 0;
+  for (const type in node.assocs) {
+    bytes += array(node.assocs[type].length);
+    types++;
+  }
+  bytes += dict(types);
+
+  let lines = 0;
+  for (const lno in node.data) {
+    const ln = node.data[lno];
+    if (ast.source[lno] !== ln) {
+      bytes += string(ln);
+    }
+    lines++;
+  }
+  bytes += dict(lines);
+
+  if (typeof node.id == 'string') {
+    bytes += string(node.id);
+  }
+
+  if (node.decl) {
+    bytes += decl_bytes(node.decl);
+  }
+
+  return bytes;
+}
+
+/**
+ * Estimates the bytes retained by a member declaration. Its type is an
+ * id into the type table, accounted for separately.
+ *
+ * @param {Decl} decl
+ * @return {number} bytes
+ */
+function decl_bytes(decl) {
+  // Fixed shape: name, names, type, quals, ptr, dims, bits, value
+  let bytes = HEADER + 8 * WORD + string(decl.name);
+
+  if (decl.names) {
+    bytes += array(decl.names.length);
+    for (const name of decl.names.slice(1)) {
+      bytes += string(name);
+    }
+  }
+
+  if (decl.dims) {
+    bytes += array(decl.dims.length);
+    for (const dim of decl.dims) {
+      bytes += string(dim);
+    }
+  }
+
+  for (const str of [decl.bits, decl.value]) {
+    if (typeof str == 'string') {
+      bytes += string(str);
+    }
+  }
+
+  return bytes;
+}
+
+/**
+ * Estimates the retained size of every AST container.
+ *
+ * @param {object} ast tree to measure
+ * @param {object|optional} peak usage sampled during the parse
+ * @return {object} report
+ */
+function stats(ast, peak) {
+  const containers = {};
+  for (const name of CONTAINERS) {
+    // The comment index and type table are only reported when built
+    if ((name != 'search' || ast.search) && (name != 'types' || ast.types)) {
+      containers[name] = create_usage();
+    }
+  }
+
+  for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR, C.SKIP]) {
+    const usage = containers[type];
+    const nodes = ast[type] || {};
+    let count = 0;
+
+    for (const id in nodes) {
+      const node = nodes[id];
+      usage.bytes += node_bytes(ast, node);
+      count++;
+
+      if (node.inner) {
+        // Inner arrays and their { ind, type } line lookups
+        const members = containers[C.MEMB];
+        const entries = node.index ? Object.keys(node.index).length : 0;
+        members.bytes += array(node.inner.length) + dict(entries) +
+          entries * (HEADER + 2 * WORD);
+
+        for (const item of node.inner) {
+          if (item && item.type == C.MEMB) {
+            members.bytes += node_bytes(ast, item);
+            members.count++;
+          }
+        }
+      }
+    }
+
+    usage.count = count;
+    usage.bytes += dict(count);
+  }
+
+  if (ast.types) {
+    // Names array plus the name to id map
+    const usage = containers.types;
+    usage.count = ast.types.size;
+    usage.bytes = array(usage.count) + dict(usage.count);
+    for (const name of ast.types.names) {
+      usage.bytes += string(name);
+    }
+  }
+
+  if (ast.search) {
+    // Posting lists by trigram, plus the line text and owner maps, whose
+    // text is shared with the comment nodes
+    const usage = containers.search;
+    usage.count = ast.search.grams.size;
+    usage.bytes = dict(usage.count) + array(ast.search.size) +
+      2 * dict(ast.search.size);
+    for (const list of ast.search.grams.values()) {
+      usage.bytes += array(list.length);
+    }
+  }
+
+  if (ast.index) {
+    const usage = containers.index;
+    for (const lno in ast.index) {
+      const entry = ast.index[lno];
+      usage.bytes += HEADER + Object.keys(entry).length * WORD +
+        (entry.sub ? array(entry.sub.length) : 0);
+      usage.count++;
+    }
+    usage.bytes += dict(usage.count);
+  }
+
+  const source = containers.source;
+  source.count = ast.source.length;
+  source.bytes = array(source.count);
+  for (let i = 0; i < ast.source.length; i++) {
+    // Partial parses leave the lines they skipped unread
+    if (ast.source[i] !== undefined) {
+      source.bytes += string(ast.source[i]);
+    }
+  }
+
+  let total = 0;
+  for (const name in containers) {
+    total += containers[name].bytes;
+  }
+
+  return {
+    containers,
+    total,
+    peak: peak ? { rss: peak.rss, heap: peak.heap } : null,
+  };
+}
+
+/**
+ * Formats a report as an aligned table.
+ *
+ * @param {object} report as returned by stats()
+ * @return {string}
+ */
+function format(report) {
+  const kb = (n) => (n / 1024).toFixed(1);
+  const rows = [['container', 'count', 'est. KB', 'share']];
+
+  for (const name in report.containers) {
+    const usage = report.containers[name];
+    const share = report.total ? usage.bytes / report.total * 100 : 0;
+    rows.push([name, usage.count, kb(usage.bytes), share.toFixed(1) + '%']);
+  }
+  rows.push(['total', '', kb(report.total), '']);
+
+  const widths = rows[0].map((_, i) =>
+    Math.max(...rows.map((r) => String(r[i]).length)));
+  const lines = rows.map((r) =>
+    r.map((c, i) => String(c)[i ? 'padStart' : 'padEnd'](widths[i])).join('  '));
+
+  if (report.peak) {
+    lines.push('');
+    lines.push(`peak rss ${kb(report.peak.rss)} KB, ` +
+      `peak heap ${kb(report.peak.heap)} KB`);
+  }
+
+  return lines.join('\n');
+}
+
+module.exports = {
+  SAMPLE_LINES,
+  create_peak,
+  sample,
+  stats,
+  format,
+};
@@ -7,12 +7,18 @@
  */
 const proc = require('process');
 const logger = require('./utils').logger;
+const S = require('./state');
 const C = require('./constants');
 /**
  * Utility log namespaced helper
  */
 const log = logger('node');
 
+/**
+ * Member declaration parser, required once a parse asks for decls.
+ */
+let decl = null;
+
 /**
  * Traverse ast tree upwards until the root is found
  * @param {object} ast tree object
@@ -20,7 +26,7 @@ const log = logger('node');
  */
 function root(ast, id) {
     const lookup = ast.index[id];
-    if (lookup.parent) {
+    if (lookup.parent !== undefined) {
         return root(ast, lookup.parent);
     } else {
         const node = ast[lookup.type][lookup.node_id];
@@ -28,33 +34,63 @@ function root(ast, id) {
     }
 }
 
+/**
+ * AST Node.
+ * Every field is initialized up front and in a fixed order, so all nodes
+ * share a single hidden class. Optional fields stay undefined until used
+ * and are therefore omitted from JSON output.
+ */
+class Node {
+    /**
+     * @param {number|string} id identifying starting line for this node.
+     * @param {string} type node type identifier.
+     */
+    constructor(id, type) {
+        this.id = id;
+        this.type = type;
+        this.assocs = {};
+        this.data = {};
+        this.parent = undefined;
+        this.inner = undefined;
+        this.index = undefined;
+        this.decl = undefined;
+    }
+
+    /**
+     * Integer tag of the node type.
+     * @return {number}
+     */
+    get tag() {
+        return C.TAG[this.type];
+    }
+}
+
 /**
  * Create new textual node representation for the AST.
  *
  * @param {number} id identifying starting line for this node.
+ * @param {string} node_type identifying the node type.
  * @param {string} assoc_type identifying associate reference type.
  * @param {number} assoc_id identifying associate reference id.
+ * @param {number} parent identifying the parent node id.
+ * @param {NodePool|optional} pool to recycle released nodes from.
  *
- * @return {object} AST Node
+ * @return {Node} AST Node
  */
 function create(id,
-    { node_type, assoc_type, assoc_id, ...extra }) {
-    // Prepare initial association references
-    let assoc_container = {};
+    { node_type, assoc_type, assoc_id, parent }, pool) {
+    const node = pool ? pool.acquire(id, node_type) : new Node(id, node_type);
 
+    // Prepare initial association references
     if (node_type != C.COMM && assoc_id) {
-        assoc_container[assoc_type] = [assoc_id];
+        node.assocs[assoc_type] = [assoc_id];
     }
 
-    return {
-        id: id,
-        type: node_type,
-        assocs: assoc_container,
-        data: {},
-        // inner: [],
-        // index: {},
-        ...extra,
-    };
+    if (parent !== undefined) {
+        node.parent = parent;
+    }
+
+    return node;
 }
 
 /**
@@ -65,14 +101,15 @@ function create(id,
  * @param {number} index ID Index for the node, typically line no.
  * @param {string} container type.
  * @param {object} opts additional attributes for the created node.
+ * @param {NodePool|optional} pool to recycle released nodes from.
  *
  * @return {object} AST Node
  */
-function cached(ast, index, container, opts) {
+function cached(ast, index, container, opts, pool) {
     let node = ast[container][index];
 
     if (!node) {
-        node = create(index, opts);
+        node = create(index, opts, pool);
         ast[container][index] = node;
     }
 
@@ -80,6 +117,44 @@ function cached(ast, index, container, opts) {
 }
 
 
+/**
+ * Whether nodes of a given tag are part of the extraction profile.
+ *
+ * @param {object} state Parser State
+ * @param {number} tag node type tag
+ * @return {boolean}
+ */
+function wanted(state, tag) {
+    return (state.want & (1 << tag)) != 0;
+}
+
+/**
+ * Container holding nodes of a given tag.
+ * Provisional nodes of unwanted kinds are kept out of the AST.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ * @param {number} tag node type tag
+ * @return {object} container
+ */
+function holder(ast, state, tag) {
+    return wanted(state, tag) ? ast[C.TYPES[tag]] : state.scratch[tag];
+}
+
+/**
+ * Records the node owning a line, used by the parser for lookbehind
+ * independently of the (optional) output index.
+ *
+ * @param {object} state Parser State
+ * @param {number} lno line number
+ * @param {number} node_id owning node
+ * @param {number} tag owning node type tag
+ */
+function track(state, lno, node_id, tag) {
+    state.line_node[lno] = node_id;
+    state.line_tag[lno] = tag;
+}
+
 /**
  *
  * Inserts entry into the index based on current state
@@ -105,6 +180,13 @@ function index(ast, state, type, opts = {}) {
         proc.exit(1);
     }
 
+    const tag = C.TAG[type];
+    track(state, state.lno, node_id, tag);
+
+    if (!state.indexed || !wanted(state, tag)) {
+        return;
+    }
+
     const data = {
         node_id: node_id,
         type: type,
@@ -130,8 +212,10 @@ function index(ast, state, type, opts = {}) {
  * @param {object} state Parser State
 */
 function insert(ast, state) {
-    const prev_index = ast.index[state.lno - 1];
-    const prev_line = prev_index && ast.source[state.lno - 1] || '';
+    const prev_lno = state.lno - 1;
+    const prev_tag = prev_lno >= 0 ? state.line_tag[prev_lno] : S.NONE;
+    const prev_id = prev_lno >= 0 ? state.line_node[prev_lno] : S.NONE;
+    const prev_line = prev_tag != S.NONE && ast.source[prev_lno] || '';
 
     const comm_starting = state.ln.indexOf('/*') == 0;
     const prev_comm_ended = prev_line.indexOf('*/') >= 0;
@@ -142,60 +226,70 @@ function insert(ast, state) {
         diff_comm_types = true;
     }
 
-    if (!state.inside[C.DEF] && (state.inside[C.COMM] || state.closing[C.COMM])) {
-        process(ast, state, C.COMM);
+    const inside = state.inside;
+    const scopes = inside | state.closing;
 
-        if (!comm_starting && !diff_comm_types && prev_index && prev_index.type == C.COMM) {
-            let target = ast[C.COMM][prev_index.node_id];
+    if (!(inside & S.IN_DEF) && (scopes & S.IN_COMM)) {
+        process(ast, state, S.COMM);
+
+        if (state.node && !comm_starting && !diff_comm_types && prev_tag == S.COMM) {
+            let target = ast[C.COMM][prev_id];
 
             if (!target) {
-                log.error('Missing target', state.lno, prev_index.node_id);
+                log.error('Missing target', state.lno, prev_id);
             }
 
-            combine(ast, target, state.node);
+            combine(ast, state, target, state.node);
         }
     }
 
-    else if (state.inside[C.CODE] || state.closing[C.CODE]) {
-        process(ast, state, C.CODE);
+    else if (scopes & S.IN_CODE) {
+        process(ast, state, S.CODE);
 
-        if (prev_index && (prev_index.type == C.DEF || prev_index.type == C.CHAR)) {
-            transform(ast, prev_index.node_id, prev_index.type, C.CODE);
-            combine(ast, ast[C.CODE][prev_index.node_id], ast[C.CODE][state.lno]);
-            if (prev_index.node_id) {
-                state.current[C.CODE] = prev_index.node_id;
+        // Preprocessor directives never lead into code, and lines
+        // following a detached node start code of their own
+        if ((prev_tag == S.DEF || prev_tag == S.CHAR) &&
+            !(state.pp && state.pp.directive == prev_lno) &&
+            transform(ast, state, prev_id, C.TYPES[prev_tag], C.CODE)) {
+            if (state.node) {
+                combine(ast, state, ast[C.CODE][prev_id], ast[C.CODE][state.lno]);
+            }
+            if (prev_id) {
+                state.current[S.CODE] = prev_id;
             }
 
-            state.previous[C.CODE] = null;
+            state.previous[S.CODE] = S.NONE;
         }
     }
 
-    else if (state.inside[C.DEF] || state.closing[C.DEF]) {
+    else if (scopes & S.IN_DEF) {
+        const def_closing = state.closing & S.IN_DEF;
+
         // Combine internal comments
-        if (!state.closing[C.DEF] && (state.inside[C.COMM] || state.closing[C.COMM])) {
-            process(ast, state, C.COMM);
+        if (!def_closing && (scopes & S.IN_COMM)) {
+            process(ast, state, S.COMM);
 
-            if (!prev_comm_ended && !diff_comm_types && prev_index &&
-                prev_index.type == C.COMM) {
-                combine(ast, ast[C.COMM][prev_index.node_id], state.node);
+            if (state.node && !prev_comm_ended && !diff_comm_types &&
+                prev_tag == S.COMM) {
+                combine(ast, state, ast[C.COMM][prev_id], state.node);
             }
         }
 
         // Look for internal struct members
-        else if (!state.closing[C.DEF] && !state.block_start &&
+        else if (!def_closing && !state.block_start &&
             state.ln.length > 1) {
-            state.current[C.MEMB] = state.lno;
-            process(ast, state, C.MEMB);
-            state.current[C.MEMB] = null;
+            state.current[S.MEMB] = state.lno;
+            process(ast, state, S.MEMB);
+            state.current[S.MEMB] = S.NONE;
         } else {
-            process(ast, state, C.DEF);
+            process(ast, state, S.DEF);
         }
     }
 
     else {
-        state.current[C.CHAR] = state.lno;
-        state.closing[C.CHAR] = true;
-        process(ast, state, C.CHAR);
+        state.current[S.CHAR] = state.lno;
+        state.closing |= S.IN_CHAR;
+        process(ast, state, S.CHAR);
     }
 }
 
@@ -204,8 +298,11 @@ function insert(ast, state) {
  *
  * @param {AST} ast master ast tree
  * @param {Node} node containing extractable comment
+ * @param {number} subline offset of the line within the node
+ * @param {NodePool|optional} pool to recycle released nodes from.
+ * @param {boolean} indexed whether the output index is being built.
  */
-function extract_inner_comment(ast, node, subline = 0) {
+function extract_inner_comment(ast, node, subline = 0, pool, indexed = true) {
     const sub_keys = Object.keys(node.data);
     const ln = node.data[sub_keys[subline]];
     const pos = parseInt(node.id) + subline;
@@ -216,19 +313,23 @@ function extract_inner_comment(ast, node, subline = 0) {
     }
 
     const extract = ln.split(ctype)
-    const data = extract[0];
-    const comm = ctype + extract[1];
+    let data = extract[0];
+    let comm = ctype + extract[1];
+    if (ast.strings) {
+        data = ast.strings.intern(data);
+        comm = ast.strings.intern(comm);
+    }
 
     node.data[subline] = data;
     if (!node.inner) { node.inner = []; }
-    cid = node.inner.length;
+    const cid = node.inner.length;
 
-    cnode = create(`${pos}.${cid + 1}`, {
+    const cnode = create(`${pos}.${cid + 1}`, {
         node_type: C.COMM,
         assoc_type: node.type,
         assoc_id: node.id,
         parent: node.id,
-    });
+    }, pool);
 
     cnode.data[node.id] = comm;
 
@@ -238,6 +339,14 @@ function extract_inner_comment(ast, node, subline = 0) {
     node.index[cnode.id] = { ind: cid, type: C.COMM }
 
     ast[C.COMM][cnode.id] = cnode;
+    if (ast.search) {
+        ast.search.add(pos, comm, cnode.id);
+    }
+
+    if (!indexed) {
+        return;
+    }
+
     ast.index[cnode.id] = {
         node_id: cnode.id,
         type: C.COMM,
@@ -247,6 +356,16 @@ function extract_inner_comment(ast, node, subline = 0) {
     }
 }
 
+/**
+ * Whether a definition node declares an enum, from its opening line.
+ *
+ * @param {Node} pnode definition node
+ * @return {boolean}
+ */
+function is_enum(pnode) {
+    return /\benum\b/.test(pnode.data[pnode.id]);
+}
+
 /**
  * Process inner nodes, ie. members of a struct
  * @param {*} ast
@@ -259,7 +378,7 @@ function inner(ast, state, pnode, type) {
         {
             node_type: type,
             parent: pnode.id,
-        });
+        }, state.pool);
 
     const inner_id = pnode.inner.length;
     let ln = state.current_line;
@@ -272,98 +391,192 @@ function inner(ast, state, pnode, type) {
     };
 
     node.data[state.lno] = ln;
+    if (state.decls) {
+        decl = decl || require('./decl');
+        node.decl = decl.parse(ln, ast.types, is_enum(pnode));
+        if (ast.strings) {
+            decl.intern(node.decl, ast.strings);
+        }
+    }
 
     // Scan for sub line comments: indexed > 1
-    if (ln.indexOf("/*") >= 1 || ln.indexOf("//") >= 1) {
-        extract_inner_comment(ast, node)
+    if (wanted(state, S.COMM) &&
+        (ln.indexOf("/*") >= 1 || ln.indexOf("//") >= 1)) {
+        extract_inner_comment(ast, node, 0, state.pool, state.indexed)
     }
 
     return node;
 }
 
+/**
+ * Shared empty index attributes for top level nodes.
+ */
+const NO_INDEX_DATA = Object.freeze({});
+
+/**
+ * Consumes a line of an unbuilt kind, keeping only the line ownership
+ * and slot bookkeeping the parser relies upon.
+ *
+ * @param {object} ast Abstract Syntax Tree
+ * @param {object} state Shared runtime state and config
+ * @param {number} tag node type tag
+ */
+function skip(ast, state, tag) {
+    state.node = null;
+    state.previous[S.REF[tag]] = S.NONE;
+    track(state, state.lno, state.current[tag], tag);
+}
+
 /**
  * Handle node insertions.
  * Updates given AST with optional node insertion and data push.
+ * Lines of kinds excluded by the extraction profile are skipped.
  *
  * @param {object} ast Abstract Syntax Tree
  * @param {object} state Shared runtime state and config
- * @param {string} type node type identifier, possible options: 'C.COMM' or 'C.CODE'.
+ * @param {number} tag node type tag, eg. S.COMM or S.CODE.
  *
  * @return {object} AST Node
  */
-function process(ast, state, type) {
-    const ref_type = state.config[type].ref;
-    const ref_id = state.previous[ref_type];
-    const ref_node = ast[ref_type][ref_id];
-    const ind = state.current[type];
-    const index_data = {};
-
-    let container;
+function process(ast, state, tag) {
+    if (!(state.build & (1 << tag))) {
+        return skip(ast, state, tag);
+    }
+
+    const type = C.TYPES[tag];
+    const ref_tag = S.REF[tag];
+    const ref_type = C.TYPES[ref_tag];
+    const ref_id = wanted(state, ref_tag) ? state.previous[ref_tag] : S.NONE;
+    const ref_node = ref_id == S.NONE ? undefined : ast[ref_type][ref_id];
+    const ind = state.current[tag];
+
+    let index_data = NO_INDEX_DATA;
     let node;
 
-    if (type == C.MEMB) {
-        const pnode = ast.node(state.current[C.DEF]);
-        index_data.parent = pnode.id;
+    if (tag == S.MEMB) {
+        const pnode = ast[C.DEF][state.current[S.DEF]];
         if (!pnode.inner) { pnode.inner = []; }
-        index_data.ind = pnode.inner.length;
+        index_data = { parent: pnode.id, ind: pnode.inner.length };
         node = inner(ast, state, pnode, type);
 
     } else {
-        container = state.config[type].container;
-        node = cached(ast, ind, container, {
-            node_type: type,
-            assoc_type: ref_type,
-            assoc_id: ref_id,
-        });
+        const container_tag = S.CONTAINER[tag];
+        const nodes = holder(ast, state, container_tag);
+        node = nodes[ind];
+
+        if (!node) {
+            // Only the latest provisional node is ever referenced
+            if (!wanted(state, container_tag)) {
+                evict(state, container_tag);
+            }
+
+            node = create(ind, {
+                node_type: type,
+                assoc_type: ref_type,
+                assoc_id: ref_id == S.NONE ? undefined : ref_id,
+            }, state.pool);
+            nodes[ind] = node;
+        }
 
-        if (type != C.COMM && ref_node) {
-            associate(ast, ref_node, node);
+        if (tag != S.COMM && ref_node) {
+            if (wanted(state, tag)) {
+                associate(ast, ref_node, node);
+            } else {
+                attach(node, ref_node);
+            }
         }
 
         //node.data.push({no: state.lno, ln: state.current_line });
         node.data[state.lno] = state.current_line;
+
+        if (tag == S.COMM && ast.search && wanted(state, tag)) {
+            ast.search.add(state.lno, state.current_line, node.id);
+        }
     }
 
     state.node = node;
-    state.previous[ref_type] = null;
+    state.previous[ref_tag] = S.NONE;
 
     index(ast, state, type, index_data);
     return node;
 }
 
+/**
+ * Drops provisional nodes of a given tag.
+ *
+ * @param {object} state Parser State
+ * @param {number} tag node type tag
+ */
+function evict(state, tag) {
+    const nodes = state.scratch[tag];
+    for (const id in nodes) {
+        if (state.pool) {
+            state.pool.recycle(nodes[id]);
+        }
+        delete nodes[id];
+    }
+}
+
 /**
  * Transform a node between various node nodes in the tree.
  *
+ * Provisional nodes are promoted into the tree when transformed into a
+ * wanted kind, and wanted nodes are dropped when transformed into an
+ * unwanted kind.
+ *
  * @param {object} ast object tree
+ * @param {object} state Parser State
  * @param {number} index into AST for the target node
  * @param {string} from - Type of node we are transforming
  * @param {string} dst - Destination Type for the Node
  *
- * @return {void}
+ * @return {boolean} false when the node is associated with a node no
+ *   longer in the tree, such as a line comment merged into the one above.
  */
-function transform(ast, index, from, dst) {
-    ast[dst][index] = ast[from][index];
-    delete ast[from][index];
+function transform(ast, state, index, from, dst) {
+    const from_tag = C.TAG[from];
+    const dst_tag = C.TAG[dst];
+    const src = holder(ast, state, from_tag);
+    const node = src[index];
+
+    state.line_tag[index] = dst_tag;
+    if (!node) {
+        // Lines of unbuilt kinds only carry their ownership across
+        return true;
+    }
+
+    delete src[index];
+
+    if (!wanted(state, dst_tag)) {
+        drop(ast, state, node, from);
+        return true;
+    }
 
-    const lookup = ast.index[index];
-    const node = ast[dst][lookup.node_id];
-    lookup.type = dst;
+    holder(ast, state, dst_tag)[index] = node;
     node.type = dst;
 
-    if (!node || !node.type) {
-        log.error(`Invalid transform on node(${index})`, node, ast.index[index]);
-        console.trace();
-        proc.exit(1);
+    const lookup = state.indexed && ast.index[index];
+    if (lookup) {
+        lookup.type = dst;
+    } else if (state.indexed && !wanted(state, from_tag)) {
+        // Provisional nodes were never indexed
+        ast.index[index] = { node_id: node.id, type: dst, sub: [] };
     }
 
-    for (assoc in node.assocs) {
-        for (i in node.assocs[assoc]) {
+    let linked = true;
+    for (const assoc in node.assocs) {
+        for (const i in node.assocs[assoc]) {
             let id = node.assocs[assoc][i];
             let n = ast[assoc][id];
-            let len = n.assocs[from].length;
+            if (!n) {
+                linked = false;
+                continue;
+            }
+
+            let len = n.assocs[from] ? n.assocs[from].length : 0;
             let clean_orig = false;
 
-            for (i2 in n.assocs[from]) {
+            for (const i2 in n.assocs[from]) {
                 if (n.assocs[from][i2] == node.id) {
                     delete n.assocs[from][i2];
                     clean_orig = true;
@@ -379,18 +592,55 @@ function transform(ast, index, from, dst) {
             n.assocs[dst].push(node.id);
         }
     }
+    return linked;
+}
+
+/**
+ * Removes a node from the tree, along with its index entries and the
+ * reciprocal associations pointing at it.
+ *
+ * @param {object} ast object tree
+ * @param {object} state Parser State
+ * @param {object} node being dropped
+ * @param {string} type the node is registered under
+ */
+function drop(ast, state, node, type) {
+    if (state.indexed) {
+        for (const ln in node.data) {
+            delete ast.index[ln];
+        }
+    }
+
+    for (const assoc in node.assocs) {
+        for (const id of node.assocs[assoc]) {
+            const n = ast[assoc] && ast[assoc][id];
+            const refs = n && n.assocs[type];
+            if (!refs) {
+                continue;
+            }
+
+            const at = refs.indexOf(node.id);
+            if (at >= 0) {
+                refs.splice(at, 1);
+            }
+            if (!refs.length) {
+                delete n.assocs[type];
+            }
+        }
+    }
 }
 
 /**
  * Combine two adjacent nodes in the tree
  *
  * @param {object} ast Tree
+ * @param {object} state Parser State
  * @param {object} no1 - Node 1
  * @param {object} no2 - Node 2
  *
  * @return {void}
  */
-function combine(ast, no1, no2) {
+function combine(ast, state, no1, no2) {
     let n1;
     let n2;
 
@@ -414,15 +664,22 @@ function combine(ast, no1, no2) {
     }
 
     // Update index shift to adjacent id
-    for (entry in n2.data) {
-        ast.index[entry].node_id = n1.id;
+    const searched = ast.search && n2.type == C.COMM;
+    for (const entry in n2.data) {
+        state.line_node[entry] = n1.id;
+        if (state.indexed) {
+            ast.index[entry].node_id = n1.id;
+        }
+        if (searched) {
+            ast.search.move(Number(entry), n1.id);
+        }
     }
 
     Object.assign(n1.data, n2.data);
 
-    const container = n2.type;
-    if (ast[container][n2.id]) {
-        delete ast[container][n2.id];
+    const container = holder(ast, state, C.TAG[n2.type]);
+    if (container[n2.id]) {
+        delete container[n2.id];
     } else {
         log.error(`Could not find node inside [${n2.node_type}]`);
     }
@@ -438,32 +695,99 @@ function combine(ast, no1, no2) {
  * @return {object} Matched AST node
  */
 function find_precedence(ast, state, node) {
-    let container;
+    return precedence(ast, state, C.TAG[node.type], node.id);
+}
+
+/**
+ * Finds the comment preceding a node, by tag and id, so that lines of
+ * unbuilt kinds are looked behind exactly as built ones.
+ *
+ * @param {object} ast - AST Tree to operate on
+ * @param {object} state - Parser State
+ * @param {number} tag - node type tag
+ * @param {number} id - node id
+ *
+ * @return {object} Matched AST node
+ */
+function precedence(ast, state, tag, id) {
     let match;
 
-    if (node.type == C.CODE ||
-        node.type == C.CHAR ||
-        node.type == C.DEF ||
-        node.type == C.MEMB) {
+    if (tag == S.CODE ||
+        tag == S.CHAR ||
+        tag == S.DEF ||
+        tag == S.MEMB) {
 
-        let prev_index = ast.index[node.id - 1];
+        let prev_lno = id - 1;
 
-        if (!prev_index) {
+        if (!(prev_lno >= 0) || state.line_tag[prev_lno] === undefined) {
             log.error('invalid prev_index');
             return;
         }
 
-        let prev_comm_id = prev_index.node_id;
-        let lookup = ast.index[prev_comm_id];
+        let prev_comm_id = state.line_node[prev_lno];
 
-        if (lookup && lookup.type == C.COMM) {
-            match = ast[lookup.type][lookup.node_id];
+        if (state.line_tag[prev_comm_id] == S.COMM) {
+            match = ast[C.COMM][state.line_node[prev_comm_id]];
         }
     }
 
     return match;
 }
 
+/**
+ * Associates the node of the current line with its preceding comment.
+ *
+ * Skipped lines still consume the comment, so that it does not attach
+ * to a later node the full parse would never have linked it to.
+ *
+ * @param {object} ast - AST Tree to operate on
+ * @param {object} state - Parser State
+ */
+function relate(ast, state) {
+    const node = state.node;
+    const tag = node ? C.TAG[node.type] : state.line_tag[state.lno];
+
+    if (tag === undefined) {
+        return;
+    }
+
+    const id = node ? node.id : state.line_node[state.lno];
+    const related = precedence(ast, state, tag, id);
+
+    if (!related) {
+        return;
+    }
+
+    if (node) {
+        if (wanted(state, tag)) {
+            associate(ast, node, related);
+        } else {
+            attach(node, related);
+        }
+    }
+
+    if (state.previous[S.COMM] == related.id) {
+        state.previous[S.COMM] = S.NONE;
+    }
+}
+
+/**
+* Link a node to a related node, one way only.
+*
+* @param {object} node - AST Node object receiving the association
+* @param {object} related - AST Node object
+*
+* @return {void}
+*/
+function attach(node, related) {
+    const ntype = related.type;
+
+    if (!node.assocs[ntype]) node.assocs[ntype] = [];
+    if (node.assocs[ntype].indexOf(related.id) < 0) {
+        node.assocs[ntype].push(related.id);
+    }
+}
+
 /**
 * Link two nodes together via recipricol association.
 *
@@ -494,6 +818,7 @@ function associate(ast, node, related) {
 }
 
 module.exports = {
+    Node,
     create,
     cached,
     root,
@@ -502,6 +827,11 @@ module.exports = {
     insert,
     transform,
     combine,
+    drop,
     associate,
+    attach,
+    wanted,
+    track,
+    relate,
     find_precedence
 }
@@ -0,0 +1,143 @@
+/**
+ * @fileOverview
+ * Node arena for long running processes.
+ * Recycles the nodes of released ASTs into subsequent parses.
+ *
+ * @name pool.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const Node = require('./node').Node;
+const C = require('./constants');
+
+/**
+ * Default upper bound of idle nodes retained by a pool.
+ */
+const DEFAULT_LIMIT = 1 << 16;
+
+/**
+ * Containers walked when releasing an AST.
+ */
+const CONTAINERS = [C.COMM, C.CODE, C.DEF, C.CHAR, C.SKIP];
+
+/**
+ * Free list of recyclable nodes.
+ * Pass an instance as `opts.pool` to the AST generators, and release
+ * each AST back into it once it is no longer referenced.
+ */
+class NodePool {
+  /**
+   * @param {number|optional} limit maximum idle nodes retained.
+   */
+  constructor(limit = DEFAULT_LIMIT) {
+    this.limit = limit;
+    this.free = [];
+    this.created = 0;
+    this.reused = 0;
+  }
+
+  /**
+   * Provides a reset node, recycled when available.
+   *
+   * @param {number|string} id node id
+   * @param {string} type node type
+   * @return {Node}
+   */
+  acquire(id, type) {
+    const node = this.free.pop();
+
+    if (!node) {
+      this.created++;
+      return new Node(id, type);
+    }
+
+    this.reused++;
+    node.id = id;
+    node.type = type;
+    node.parent = undefined;
+    node.inner = undefined;
+    node.index = undefined;
+    node.decl = undefined;
+    return node;
+  }
+
+  /**
+   * Recycles a single node.
+   * Frozen nodes may be shared by published snapshots and are skipped.
+   * Only the node itself is reused: deleting the keys of its assocs and
+   * data would turn them into slow dictionary mode objects, so both are
+   * replaced.
+   *
+   * @param {Node} node no longer referenced
+   */
+  recycle(node) {
+    if (this.free.length >= this.limit || !(node instanceof Node) ||
+      Object.isFrozen(node)) {
+      return;
+    }
+
+    node.assocs = {};
+    node.data = {};
+    node.inner = undefined;
+    node.index = undefined;
+    node.decl = undefined;
+    this.free.push(node);
+  }
+
+  /**
+   * Releases every node of an AST back into the pool, along with its
+   * references to interned strings.
+   * The AST is emptied and must not be used afterwards.
+   *
+   * @param {object} ast tree to be released
+   */
+  release(ast) {
+    for (const container of CONTAINERS) {
+      const nodes = ast[container];
+
+      for (const id in nodes) {
+        const node = nodes[id];
+        const inner = node.inner;
+
+        // Inner comments live in the comments container as well,
+        // so only members are recycled through their parent.
+        if (inner) {
+          for (let i = 0; i < inner.length; i++) {
+            if (inner[i] && inner[i].type == C.MEMB) {
+              this.recycle(inner[i]);
+            }
+          }
+        }
+
+        this.recycle(node);
+      }
+
+      ast[container] = {};
+    }
+
+    if (ast.strings) {
+      ast.strings.pool.release(ast);
+    }
+
+    ast.index = {};
+    ast.source = [];
+    ast.search = null;
+  }
+
+  /**
+   * Allocation counters.
+   * @return {object}
+   */
+  stats() {
+    return {
+      created: this.created,
+      reused: this.reused,
+      idle: this.free.length,
+    };
+  }
+}
+
+module.exports = {
+  NodePool,
+};
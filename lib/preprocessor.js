@@ -0,0 +1,444 @@
+/**
+ * @fileOverview
+ * Preprocessor aware front stage.
+ *
+ * Conditional directives are evaluated against a configured set of
+ * defined and undefined macros, along with the `#define` and `#undef`
+ * lines seen so far. Regions found to be disabled are skipped with a
+ * scan for the matching `#else`, `#elif` or `#endif` only, bypassing the
+ * tokenizer, and are recorded as a single span node. Conditions that
+ * cannot be decided are parsed as usual, every branch of them.
+ *
+ * Directive lines are kept away from the tokenizer's function and brace
+ * detection, and backslash continued directives are folded into the node
+ * of their first line.
+ *
+ * @name preprocessor.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const node = require('./node');
+const classifier = require('./classifier');
+const S = require('./state');
+const C = require('./constants');
+
+/**
+ * Outcomes of the front stage for a line.
+ */
+const PASS = 0;       // regular line, parsed as usual
+const CONSUMED = 1;   // handled here, the parse of the line ends
+const DIRECTIVE = 2;  // parsed as usual, without token detection
+
+const HASH = 0x23;
+
+const DIRECTIVE_RE = /^#\s*([a-z]+)\s*(.*)$/;
+const DEFINED_RE = /^(!?)\s*defined\s*\(?\s*(\w+)\s*\)?$/;
+const NUMBER_RE = /^(0[xX][0-9a-fA-F]+|\d+)[uUlL]*$/;
+const NAME_RE = /^\w+$/;
+const COMMENT_RE = /\/\*.*?\*\/|\/\/.*$/g;
+
+/**
+ * Normalizes a list of macro names.
+ *
+ * @param {array|string|object|undefined} list array, comma separated
+ *   string, or object keyed by name.
+ * @return {array} names
+ */
+function names(list) {
+  if (!list) {
+    return [];
+  }
+
+  if (typeof list == 'string') {
+    list = list.split(',');
+  } else if (!Array.isArray(list)) {
+    list = Object.keys(list);
+  }
+
+  return list.map((name) => String(name).trim()).filter((name) => name);
+}
+
+/**
+ * Creates the front stage state, when enabled by the options.
+ *
+ * Options:
+ *   preprocess - true to enable with no macros configured.
+ *   defines    - macros known to be defined.
+ *   undefines  - macros known not to be defined.
+ *
+ * @param {object} opts generation options
+ * @return {object|null} front stage state
+ */
+function create(opts = {}) {
+  if (!opts.preprocess && !opts.defines && !opts.undefines) {
+    return null;
+  }
+
+  const macros = new Map();
+  for (const name of names(opts.defines)) {
+    macros.set(name, true);
+  }
+  for (const name of names(opts.undefines)) {
+    macros.set(name, false);
+  }
+
+  return {
+    // Known macros: true when defined, false when not
+    macros,
+
+    // Open conditionals, innermost last
+    frames: [],
+
+    // Open conditionals whose branch could not be decided
+    unknown: 0,
+
+    // Disabled region being skipped
+    skipping: false,
+    depth: 0,
+    span: S.NONE,
+
+    // Backslash continued directive
+    continued: false,
+    macro: S.NONE,
+
+    // Last directive line, kept out of code following it
+    directive: S.NONE,
+  };
+}
+
+/**
+ * Whether a macro is defined, null when unknown.
+ */
+function defined(pp, name) {
+  return pp.macros.has(name) ? pp.macros.get(name) : null;
+}
+
+/**
+ * Evaluates the simple forms of an `#if` expression.
+ *
+ * @param {object} pp front stage state
+ * @param {string} expr condition
+ * @return {boolean|null} null when it cannot be decided
+ */
+function evaluate(pp, expr) {
+  expr = expr.replace(COMMENT_RE, '').trim();
+
+  if (NUMBER_RE.test(expr)) {
+    return parseInt(expr) != 0;
+  }
+
+  let m = DEFINED_RE.exec(expr);
+  if (m) {
+    const value = defined(pp, m[2]);
+    return value === null ? null : value != (m[1] == '!');
+  }
+
+  // Undefined macros evaluate to 0
+  if (NAME_RE.test(expr) && defined(pp, expr) === false) {
+    return false;
+  }
+
+  return null;
+}
+
+/**
+ * Evaluates the condition of an opening directive.
+ *
+ * @param {object} pp front stage state
+ * @param {string} name directive
+ * @param {string} rest condition
+ * @return {boolean|null}
+ */
+function condition(pp, name, rest) {
+  if (name == 'if' || name == 'elif') {
+    return evaluate(pp, rest);
+  }
+
+  const value = defined(pp, rest.replace(COMMENT_RE, '').trim());
+  if (value === null) {
+    return null;
+  }
+  return name == 'ifdef' ? value : !value;
+}
+
+/**
+ * Opens a conditional frame.
+ */
+function open(pp, value) {
+  const known = value !== null;
+  pp.frames.push({ known, taken: value === true });
+  if (!known) {
+    pp.unknown++;
+  }
+}
+
+/**
+ * Closes the innermost conditional frame.
+ */
+function close(pp) {
+  const frame = pp.frames.pop();
+  if (frame && !frame.known) {
+    pp.unknown--;
+  }
+}
+
+/**
+ * Marks the innermost frame as undecided from one of its branches on.
+ */
+function undecided(pp, frame) {
+  if (frame.known) {
+    frame.known = false;
+    pp.unknown++;
+  }
+}
+
+/**
+ * Starts skipping a disabled region from the current line.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ */
+function begin(ast, state) {
+  const pp = state.pp;
+  pp.skipping = true;
+  pp.depth = 0;
+  pp.span = state.lno;
+
+  // Disabled regions break associations, as blank lines do
+  if (!(state.inside & (S.IN_CODE | S.IN_DEF))) {
+    state.previous.fill(S.NONE);
+  } else {
+    state.previous[S.COMM] = S.NONE;
+  }
+
+  if (node.wanted(state, S.SKIP)) {
+    const span = node.create(state.lno, { node_type: C.SKIP }, state.pool);
+    span.data[state.lno] = state.current_line;
+    ast[C.SKIP][state.lno] = span;
+  }
+
+  node.index(ast, state, C.SKIP, { node_id: state.lno });
+}
+
+/**
+ * Ends the disabled region at the given line, inclusive.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ * @param {number} lno last line of the region
+ */
+function end(ast, state, lno) {
+  const pp = state.pp;
+  const span = ast[C.SKIP][pp.span];
+
+  if (span && lno != pp.span) {
+    span.data[lno] = ast.source[lno];
+  }
+
+  pp.skipping = false;
+  pp.span = S.NONE;
+}
+
+/**
+ * Scans a line of a disabled region, only looking for the directives
+ * that may end it. Every line of the region is indexed to its span.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ */
+function skip(ast, state) {
+  const pp = state.pp;
+  node.index(ast, state, C.SKIP, { node_id: pp.span });
+
+  const ln = state.ln;
+  if (ln.charCodeAt(0) != HASH) {
+    return;
+  }
+
+  const m = DIRECTIVE_RE.exec(ln);
+  if (!m) {
+    return;
+  }
+
+  const name = m[1];
+  if (name == 'if' || name == 'ifdef' || name == 'ifndef') {
+    pp.depth++;
+  }
+
+  else if (name == 'endif') {
+    if (pp.depth) {
+      pp.depth--;
+    } else {
+      close(pp);
+      end(ast, state, state.lno);
+    }
+  }
+
+  else if (!pp.depth && (name == 'else' || name == 'elif')) {
+    const frame = pp.frames[pp.frames.length - 1];
+    if (!frame || frame.taken) {
+      return;
+    }
+
+    const value = name == 'else' ? true : condition(pp, name, m[2]);
+    if (value === null) {
+      undecided(pp, frame);
+    } else if (value) {
+      frame.taken = true;
+    } else {
+      return;
+    }
+    end(ast, state, state.lno);
+  }
+}
+
+/**
+ * Folds a continuation line into the node of its directive.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ * @return {number} outcome for the line
+ */
+function continuation(ast, state) {
+  const pp = state.pp;
+  pp.continued = state.current_line.trimEnd().endsWith('\\');
+  pp.directive = state.lno;
+
+  if (pp.macro == S.NONE) {
+    return DIRECTIVE;
+  }
+
+  const id = pp.macro;
+  const nodes = node.wanted(state, S.CHAR) ? ast[C.CHAR] :
+    state.scratch[S.CHAR];
+  if (nodes[id]) {
+    nodes[id].data[state.lno] = state.current_line;
+  }
+  node.index(ast, state, C.CHAR, { node_id: id });
+
+  if (!pp.continued) {
+    pp.macro = S.NONE;
+  }
+  return CONSUMED;
+}
+
+/**
+ * Runs the front stage on the current line.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ * @return {number} PASS, CONSUMED or DIRECTIVE
+ */
+function line(ast, state) {
+  const pp = state.pp;
+
+  if (pp.skipping) {
+    skip(ast, state);
+    return CONSUMED;
+  }
+
+  if (pp.continued) {
+    return continuation(ast, state);
+  }
+
+  const ln = state.ln;
+  if (ln.charCodeAt(0) != HASH || (state.inside & S.IN_COMM)) {
+    return PASS;
+  }
+
+  const m = DIRECTIVE_RE.exec(ln);
+  if (!m) {
+    return PASS;
+  }
+
+  const name = m[1];
+  const rest = m[2];
+  const frame = pp.frames[pp.frames.length - 1];
+
+  switch (name) {
+    case 'if':
+    case 'ifdef':
+    case 'ifndef': {
+      const value = condition(pp, name, rest);
+      open(pp, value);
+      if (value === false) {
+        begin(ast, state);
+        return CONSUMED;
+      }
+      break;
+    }
+
+    case 'elif':
+    case 'else':
+      // A decided frame only gets here through its taken branch
+      if (frame && frame.known) {
+        begin(ast, state);
+        return CONSUMED;
+      }
+      break;
+
+    case 'endif':
+      close(pp);
+      break;
+
+    case 'define':
+    case 'undef': {
+      const macro = NAME_RE.exec(rest.split(/[\s(]/, 1)[0]);
+      if (macro) {
+        // Definitions under undecided branches may not happen at all
+        if (pp.unknown) {
+          pp.macros.delete(macro[0]);
+        } else {
+          pp.macros.set(macro[0], name == 'define');
+        }
+      }
+      break;
+    }
+  }
+
+  if (state.current_line.trimEnd().endsWith('\\')) {
+    pp.continued = true;
+    pp.macro = state.inside & (S.IN_CODE | S.IN_DEF) ? S.NONE : state.lno;
+  }
+
+  pp.directive = state.lno;
+  return DIRECTIVE;
+}
+
+/**
+ * Clears the token features of a directive line, so that it neither
+ * opens nor closes scopes.
+ *
+ * @param {Scan} scan line features
+ */
+function neutral(scan) {
+  scan.kind &= classifier.BLOCK_CLOSE;
+  scan.open = 0;
+  scan.close = 0;
+  scan.semi = -1;
+}
+
+/**
+ * Closes a disabled region left open at the end of the input.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ */
+function finish(ast, state) {
+  const pp = state.pp;
+  if (pp && pp.skipping) {
+    end(ast, state, state.lno);
+  }
+}
+
+module.exports = {
+  PASS,
+  CONSUMED,
+  DIRECTIVE,
+  create,
+  evaluate,
+  line,
+  neutral,
+  finish,
+};
@@ -0,0 +1,174 @@
+/**
+ * @fileOverview
+ * Cooperative slice scheduler.
+ *
+ * Long running work is split into tasks, each run for at most its time
+ * budget per slice. One slice runs per event loop turn, scheduled with
+ * `setImmediate`, so timers and I/O of the host process are served in
+ * between. Pending tasks are picked by priority, round robin within the
+ * same priority, with starved lower priority tasks aged in.
+ *
+ * @name scheduler.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+/**
+ * Priority levels, lower runs first.
+ */
+const PRIORITY = {
+  interactive: 0,
+  normal: 1,
+  background: 2,
+};
+
+/**
+ * Default time budget of a slice, in milliseconds.
+ */
+const DEFAULT_BUDGET = 2;
+
+/**
+ * Slices a waiting task may be passed over by higher priority work
+ * before it is run regardless.
+ */
+const DEFAULT_AGING = 16;
+
+/**
+ * High resolution wall clock in milliseconds.
+ *
+ * @return {number}
+ */
+function now() {
+  return Number(process.hrtime.bigint()) / 1e6;
+}
+
+/**
+ * Resolves a priority name or level.
+ *
+ * @param {string|number|optional} priority
+ * @return {number} level
+ */
+function level(priority) {
+  if (priority === undefined) {
+    return PRIORITY.normal;
+  }
+
+  const lvl = typeof priority == 'number' ? priority : PRIORITY[priority];
+  if (!(lvl >= 0 && lvl <= PRIORITY.background)) {
+    throw new Error(`Unknown scheduling priority: ${priority}`);
+  }
+  return lvl;
+}
+
+class Scheduler {
+  /**
+   * @param {number|optional} aging slices before starved tasks run.
+   */
+  constructor(aging = DEFAULT_AGING) {
+    this.aging = aging;
+    this.queues = Object.keys(PRIORITY).map(() => []);
+    this.pending = false;
+    this.slices = 0;
+    this.tick = this.tick.bind(this);
+  }
+
+  /**
+   * Queues a task for slicing.
+   *
+   * The task is called with the deadline of its slice, and returns true
+   * while it has more work to do.
+   *
+   * @param {function} task work to be run in slices
+   * @param {string|number|optional} priority name or level
+   * @param {number|optional} budget milliseconds per slice
+   */
+  schedule(task, priority, budget = DEFAULT_BUDGET) {
+    this.queues[level(priority)].push({ task, budget, waited: 0 });
+
+    if (!this.pending) {
+      this.pending = true;
+      setImmediate(this.tick);
+    }
+  }
+
+  /**
+   * Picks the queue to run the next slice from.
+   * @return {number} priority level, -1 when idle
+   */
+  next() {
+    let pick = -1;
+
+    for (let p = 0; p < this.queues.length; p++) {
+      const queue = this.queues[p];
+      if (!queue.length) {
+        continue;
+      }
+
+      if (pick < 0) {
+        pick = p;
+      } else if (queue[0].waited >= this.aging) {
+        pick = p;
+        break;
+      }
+    }
+
+    for (let p = 0; p < this.queues.length; p++) {
+      if (p != pick && this.queues[p].length) {
+        this.queues[p][0].waited++;
+      }
+    }
+
+    return pick;
+  }
+
+  /**
+   * Runs a single slice, then yields to the event loop.
+   */
+  tick() {
+    const pick = this.next();
+    if (pick < 0) {
+      this.pending = false;
+      return;
+    }
+
+    const queue = this.queues[pick];
+    const entry = queue.shift();
+    entry.waited = 0;
+    this.slices++;
+
+    let more = false;
+    try {
+      more = entry.task(now() + entry.budget);
+    } finally {
+      if (more) {
+        queue.push(entry);
+      }
+
+      if (this.queues.some((q) => q.length)) {
+        setImmediate(this.tick);
+      } else {
+        this.pending = false;
+      }
+    }
+  }
+}
+
+/**
+ * Scheduler shared by parses not given one explicitly.
+ */
+let shared = null;
+
+Scheduler.shared = () => {
+  if (!shared) {
+    shared = new Scheduler();
+  }
+  return shared;
+};
+
+module.exports = {
+  PRIORITY,
+  DEFAULT_BUDGET,
+  Scheduler,
+  level,
+  now,
+};
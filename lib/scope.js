@@ -6,7 +6,7 @@
  * @license MIT
  */
 
-const C = require('./constants');
+const S = require('./state');
 
 /**
  * Scope Depth processor.
@@ -18,25 +18,25 @@ const C = require('./constants');
 */
 function depths(ast, state) {
     // Detect closing scope depths
-    const scope_open = (state.ln.match(/{/g) || []).length;
-    const scope_close = (state.ln.match(/}/g) || []).length;
+    const scope_open = state.scan.open;
+    const scope_close = state.scan.close;
     const scope_delta = (scope_close - scope_open) - state.depth;
-    const closing = state.ln.indexOf('}') >= 0;
+    const closing = scope_close > 0;
 
-    if (state.inside[C.CODE] || state.inside[C.DEF]) {
+    if (state.inside & (S.IN_CODE | S.IN_DEF)) {
       // Close the scope if ; or } is present for struct / func respectively
       if (scope_delta == 0) {
         state.depth = 0;
-  
+
         // Handle definitions before C.CODE points for nesting realization
-        if (state.inside[C.DEF]) {
-          if (state.ln.indexOf(';') >= 1 || (closing && scope_delta == 0)) {
-            delete state.inside[C.DEF];
-            state.closing[C.DEF] = true;
+        if (state.inside & S.IN_DEF) {
+          if (state.scan.semi >= 1 || (closing && scope_delta == 0)) {
+            state.inside &= ~S.IN_DEF;
+            state.closing |= S.IN_DEF;
           }
-        } else if (state.inside[C.CODE] && closing) {
-          delete state.inside[C.CODE];
-          state.closing[C.CODE] = true;
+        } else if ((state.inside & S.IN_CODE) && closing) {
+          state.inside &= ~S.IN_CODE;
+          state.closing |= S.IN_CODE;
         }
       } else if (scope_open > scope_close) {
         // Increasing scope depth
@@ -44,35 +44,25 @@ function depths(ast, state) {
       }
     }
   }
-  
+
   /**
   * Iterates scope tracking state, preparing for the next round.
+   * Every closing slot becomes the previous node of its kind.
    *
    * @param {object} ast Tree
    * @param {object} state Parser State
   */
   function iterate(ast, state) {
-    if (state.closing[C.DEF]) {
-      state.previous[C.DEF] = state.current[C.DEF];
-      delete state.current[C.DEF];
-    }
-  
-    if (state.closing[C.CODE]) {
-      state.previous[C.CODE] = state.current[C.CODE];
-      delete state.current[C.CODE];
-    }
-  
-    if (state.closing[C.COMM]) {
-      state.previous[C.COMM] = state.current[C.COMM];
-      delete state.current[C.COMM];
-    }
+    let closing = state.closing;
 
-    if (state.closing[C.CHAR]) {
-      state.previous[C.CHAR] = state.current[C.CHAR];
-      delete state.current[C.CHAR];
+    while (closing) {
+      const slot = 31 - Math.clz32(closing);
+      state.previous[slot] = state.current[slot];
+      state.current[slot] = S.NONE;
+      closing &= ~(1 << slot);
     }
   }
 
   module.exports = {
       depths, iterate
-  }
\ No newline at end of file
+  }
@@ -0,0 +1,261 @@
+/**
+ * @fileOverview
+ * Trigram index over comment text.
+ *
+ * Comment lines are indexed as their nodes are built: each line is
+ * posted under every trigram of its lowercased text. A search intersects
+ * the posting lists of the trigrams of its query, and only checks the
+ * lines left for the actual substring, rather than scanning every
+ * comment. Matches are found within single lines.
+ *
+ * Postings are kept by line, as lines keep their number when comment
+ * nodes are combined; the node owning each line is tracked alongside.
+ *
+ * @name search.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+
+/**
+ * Persisted format version.
+ */
+const VERSION = 1;
+
+/**
+ * Trigram key of the three UTF-16 code units of a string at an offset.
+ * Units are folded into 10 bits each, keeping keys small integers; the
+ * few trigrams of wider characters sharing a key only add candidates,
+ * which are checked against the text anyway.
+ */
+function gram(str, i) {
+  return (str.charCodeAt(i) & 0x3ff) << 20 |
+    (str.charCodeAt(i + 1) & 0x3ff) << 10 | (str.charCodeAt(i + 2) & 0x3ff);
+}
+
+/**
+ * Intersects two ascending posting lists.
+ */
+function intersect(a, b) {
+  const out = [];
+  let i = 0;
+  let j = 0;
+
+  while (i < a.length && j < b.length) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (a[i] > b[j]) {
+      j++;
+    } else {
+      out.push(a[i]);
+      i++;
+      j++;
+    }
+  }
+  return out;
+}
+
+/**
+ * Inverted index of comment lines by trigram.
+ * Lines are expected to be added in ascending order, as parsed.
+ */
+class CommentIndex {
+  constructor() {
+    this.grams = new Map();   // trigram => ascending line numbers
+    this.lines = [];          // indexed lines, ascending
+    this.text = new Map();    // line => comment text
+    this.owner = new Map();   // line => id of the comment node
+  }
+
+  /**
+   * Number of lines indexed.
+   * @return {number}
+   */
+  get size() {
+    return this.lines.length;
+  }
+
+  /**
+   * Indexes a comment line.
+   *
+   * @param {number} lno line number
+   * @param {string} text comment text of the line
+   * @param {number|string} id comment node holding the line
+   */
+  add(lno, text, id) {
+    if (this.text.has(lno)) {
+      return;
+    }
+
+    this.lines.push(lno);
+    this.text.set(lno, text);
+    this.owner.set(lno, id);
+
+    const lower = text.toLowerCase();
+    for (let i = 0; i + 3 <= lower.length; i++) {
+      const key = gram(lower, i);
+      const list = this.grams.get(key);
+
+      if (!list) {
+        this.grams.set(key, [lno]);
+      } else if (list[list.length - 1] != lno) {
+        list.push(lno);
+      }
+    }
+  }
+
+  /**
+   * Moves a line over to the node it was combined into.
+   *
+   * @param {number} lno line number
+   * @param {number|string} id comment node now holding the line
+   */
+  move(lno, id) {
+    if (this.owner.has(lno)) {
+      this.owner.set(lno, id);
+    }
+  }
+
+  /**
+   * Lines which may hold a query, from their posting lists.
+   *
+   * @param {string} query lowercased
+   * @return {array} ascending line numbers
+   */
+  candidates(query) {
+    if (query.length < 3) {
+      return this.lines;
+    }
+
+    const lists = [];
+    const seen = new Set();
+    for (let i = 0; i + 3 <= query.length; i++) {
+      const key = gram(query, i);
+      if (seen.has(key)) {
+        continue;
+      }
+      seen.add(key);
+
+      const list = this.grams.get(key);
+      if (!list) {
+        return [];
+      }
+      lists.push(list);
+    }
+
+    // Shortest lists first keep the intersections small
+    lists.sort((a, b) => a.length - b.length);
+
+    let lines = lists[0];
+    for (let i = 1; i < lists.length && lines.length; i++) {
+      lines = intersect(lines, lists[i]);
+    }
+    return lines;
+  }
+
+  /**
+   * Finds the comment lines holding a substring.
+   *
+   * Options:
+   *   ignore_case - match regardless of case.
+   *
+   * @param {string} query substring searched for
+   * @param {object} opts
+   * @return {array} matches, as { line, id, text }, by line
+   */
+  search(query, opts = {}) {
+    query = String(query);
+    const lower = query.toLowerCase();
+    const matches = [];
+
+    for (const lno of this.candidates(lower)) {
+      const text = this.text.get(lno);
+      const found = opts.ignore_case ?
+        text.toLowerCase().indexOf(lower) >= 0 : text.indexOf(query) >= 0;
+
+      if (found) {
+        matches.push({ line: lno, id: this.owner.get(lno), text });
+      }
+    }
+    return matches;
+  }
+
+  /**
+   * Persisted form, with posting lists delta encoded.
+   * @return {object}
+   */
+  toJSON() {
+    const grams = {};
+    for (const [key, list] of this.grams) {
+      const deltas = new Array(list.length);
+      for (let i = 0; i < list.length; i++) {
+        deltas[i] = i ? list[i] - list[i - 1] : list[i];
+      }
+      grams[key] = deltas;
+    }
+
+    return {
+      version: VERSION,
+      lines: this.lines.map((lno) =>
+        [lno, this.owner.get(lno), this.text.get(lno)]),
+      grams,
+    };
+  }
+
+  /**
+   * Restores a persisted index.
+   *
+   * @param {object} data as returned by toJSON
+   * @return {CommentIndex}
+   */
+  static from(data) {
+    if (!data || data.version !== VERSION) {
+      throw new Error('Unsupported comment index');
+    }
+
+    const index = new CommentIndex();
+    for (const [lno, id, text] of data.lines) {
+      index.lines.push(lno);
+      index.text.set(lno, text);
+      index.owner.set(lno, id);
+    }
+
+    for (const key in data.grams) {
+      const list = data.grams[key];
+      for (let i = 1; i < list.length; i++) {
+        list[i] += list[i - 1];
+      }
+      index.grams.set(Number(key), list);
+    }
+    return index;
+  }
+}
+
+/**
+ * Writes an index atomically, so readers never see a partial file.
+ *
+ * @param {CommentIndex} index
+ * @param {string} file destination
+ */
+function save(index, file) {
+  const tmp = `${file}.${process.pid}.tmp`;
+  fs.writeFileSync(tmp, JSON.stringify(index));
+  fs.renameSync(tmp, file);
+}
+
+/**
+ * Reads a persisted index.
+ *
+ * @param {string} file path
+ * @return {CommentIndex}
+ */
+function load(file) {
+  return CommentIndex.from(JSON.parse(fs.readFileSync(file, 'utf8')));
+}
+
+module.exports = {
+  CommentIndex,
+  save,
+  load,
+};
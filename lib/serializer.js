@@ -0,0 +1,139 @@
+/**
+ * @fileOverview
+ * JSON serialization of ASTs and snapshots.
+ *
+ * Output is byte for byte that of `JSON.stringify`, pretty printed with
+ * four spaces or compact. Generated trees are written by JSON.stringify
+ * itself, which V8 already specializes per object shape.
+ *
+ * Writers generated per node shape were measured against it, and were
+ * several times slower, so the AST path is left to JSON.stringify.
+ *
+ * Snapshot data is frozen and shared between versions, so its JSON never
+ * changes either: objects are assembled from the fragments of their
+ * values, and the fragments written by the latest two serializations in
+ * each mode are kept, one per value. Serializing a version which differs
+ * from the previous one by a few nodes only writes those nodes, while
+ * fragments of values no longer serialized are let go of.
+ *
+ * @name serializer.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const INDENT = '    ';
+
+/**
+ * Fragments of frozen values by mode, pretty printed first, written or
+ * reused by the current and the previous serialization.
+ */
+const FRAGMENTS = [false, true].map(() =>
+  ({ current: new WeakMap(), previous: new WeakMap() }));
+
+/**
+ * Serializes data, as `JSON.stringify(data, null, '    ')` would, or as
+ * `JSON.stringify(data)` when compact.
+ *
+ * @param {*} data
+ * @param {boolean|optional} compact whether to leave out whitespace
+ * @return {string}
+ */
+function json(data, compact = false) {
+  return compact ? JSON.stringify(data) : JSON.stringify(data, null, INDENT);
+}
+
+/**
+ * Starts a serialization in a mode: fragments the previous one did not
+ * reuse are dropped.
+ *
+ * @param {boolean|optional} compact whether to leave out whitespace
+ */
+function begin(compact = false) {
+  const cache = FRAGMENTS[compact ? 1 : 0];
+  cache.previous = cache.current;
+  cache.current = new WeakMap();
+}
+
+/**
+ * JSON of a frozen value at a depth, reused from the previous
+ * serialization when written at the same depth.
+ *
+ * @param {object} value frozen, or otherwise never mutated
+ * @param {number} depth nesting depth, 0 for top level values
+ * @param {boolean} compact whether to leave out whitespace
+ * @param {function} write given the value, depth and mode, its JSON
+ * @return {string}
+ */
+function cached(value, depth, compact, write) {
+  const cache = FRAGMENTS[compact ? 1 : 0];
+  // Compact output reads the same at any depth
+  const at = compact ? 0 : depth;
+
+  let entry = cache.current.get(value);
+  if (entry === undefined || entry.depth != at) {
+    entry = cache.previous.get(value);
+    if (entry === undefined || entry.depth != at) {
+      entry = { depth: at, out: write(value, depth, compact) };
+    }
+    cache.current.set(value, entry);
+  }
+  return entry.out;
+}
+
+function write(value, depth, compact) {
+  const out = json(value, compact);
+
+  // Strings hold no raw line breaks, only those of the layout do
+  return compact || !depth ? out :
+    out.replace(/\n/g, '\n' + INDENT.repeat(depth));
+}
+
+/**
+ * JSON of a value nested at a depth, as written within its parents.
+ * Fragments of frozen objects are cached.
+ *
+ * @param {*} value must serialize to JSON, ie. not be undefined.
+ * @param {number} depth nesting depth, 0 for top level values
+ * @param {boolean|optional} compact whether to leave out whitespace
+ * @return {string}
+ */
+function fragment(value, depth, compact = false) {
+  return value !== null && typeof value == 'object' && Object.isFrozen(value) ?
+    cached(value, depth, compact, write) : write(value, depth, compact);
+}
+
+/**
+ * JSON of an object from the fragments of its values.
+ *
+ * @param {array} keys in output order
+ * @param {array} parts fragment of each key's value
+ * @param {number} depth nesting depth of the object
+ * @param {boolean|optional} compact whether to leave out whitespace
+ * @return {string}
+ */
+function object(keys, parts, depth, compact = false) {
+  if (!keys.length) {
+    return '{}';
+  }
+
+  // Joined into a single flat string: cached fragments are copied once,
+  // rather than kept as ropes to be walked by every reader
+  const inner = compact ? '' : '\n' + INDENT.repeat(depth + 1);
+  const colon = compact ? ':' : ': ';
+  const out = new Array(2 * keys.length + 1);
+  for (let i = 0; i < keys.length; i++) {
+    out[2 * i] = (i ? ',' : '{') + inner + JSON.stringify(String(keys[i])) +
+      colon;
+    out[2 * i + 1] = parts[i];
+  }
+  out[2 * keys.length] = (compact ? '' : '\n' + INDENT.repeat(depth)) + '}';
+  return out.join('');
+}
+
+module.exports = {
+  json,
+  begin,
+  cached,
+  fragment,
+  object,
+};
@@ -0,0 +1,557 @@
+/**
+ * @fileOverview
+ * AST layout in shared memory.
+ *
+ * `share(ast)` lays a generated AST out into a single SharedArrayBuffer:
+ * integer columns for nodes, their spans and parents, inner lists,
+ * association edges and data lines, followed by a UTF-8 string region
+ * holding the source along with the few strings not found in it.
+ *
+ * The buffer is handed to worker threads with `postMessage` without
+ * being copied, where a SharedAST reads it in place. Nodes are only
+ * decoded once requested, so the handoff costs the same whatever the
+ * size of the AST.
+ *
+ * Node ids are either line numbers, or `line.sub` strings for the inner
+ * comments of members; both are stored as a (line, sub) pair, with a sub
+ * of -1 for line number ids.
+ *
+ * @name shared.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const C = require('./constants');
+const TypeTable = require('./types').TypeTable;
+
+/**
+ * Layout identification, 'CAST', and version.
+ */
+const MAGIC = 0x43415354;
+const VERSION = 1;
+
+/**
+ * Header words: counts, the types string, then the first row and row
+ * count of each container, indexed by tag.
+ */
+const H_MAGIC = 0;
+const H_VERSION = 1;
+const H_ROWS = 2;
+const H_LINES = 3;
+const H_INNER = 4;
+const H_EDGES = 5;
+const H_DATA = 6;
+const H_SUBS = 7;
+const H_BYTES = 8;
+const H_TYPES = 9;
+const H_TYPES_LEN = 10;
+const H_CONTAINERS = 11;
+const HEADER = H_CONTAINERS + 2 * C.TYPES.length;
+
+/**
+ * Node row fields.
+ */
+const R_LINE = 0;
+const R_SUB = 1;
+const R_TAG = 2;
+const R_START = 3;       // first and last line of the node
+const R_END = 4;
+const R_PARENT = 5;      // parent id, as a line and sub pair
+const R_PARENT_SUB = 6;
+const R_INNER = 7;       // range of the inner list
+const R_INNER_LEN = 8;
+const R_EDGES = 9;       // range of the association edges
+const R_EDGES_LEN = 10;
+const R_DATA = 11;       // range of the data entries
+const R_DATA_LEN = 12;
+const R_DECL = 13;       // decl json in the string region
+const R_DECL_LEN = 14;
+const ROW = 15;
+
+/**
+ * Words per edge (tag, line, sub), data entry (line, offset, length)
+ * and sub id (line, sub, row). Data entries with an offset of -1 are
+ * the source line itself.
+ */
+const EDGE = 3;
+const DATA = 3;
+const SUB = 3;
+
+const NONE = -1;
+const ABSENT = -2;
+
+/**
+ * Containers laid out, in order. Members are reached through their
+ * parent's inner list.
+ */
+const CONTAINERS = C.TYPES.filter((type) => type != C.MEMB);
+
+/**
+ * Splits a node id into its line and sub parts.
+ *
+ * @param {number|string} id
+ * @return {array} [line, sub]
+ */
+function split_id(id) {
+  if (typeof id == 'number') {
+    return [id, NONE];
+  }
+
+  const dot = id.indexOf('.');
+  if (dot < 0) {
+    return [Number(id), NONE];
+  }
+  return [Number(id.slice(0, dot)), Number(id.slice(dot + 1))];
+}
+
+function join_id(line, sub) {
+  return sub == NONE ? line : `${line}.${sub}`;
+}
+
+/**
+ * Int32 word offsets of every section, from the header counts.
+ */
+function layout(h) {
+  const rows = HEADER;
+  const inner = rows + h[H_ROWS] * ROW;
+  const edges = inner + h[H_INNER];
+  const data = edges + h[H_EDGES] * EDGE;
+  const lines = data + h[H_DATA] * DATA;
+  const by_line = lines + h[H_LINES] + 1;
+  const subs = by_line + h[H_LINES];
+  const strings = subs + h[H_SUBS] * SUB;
+  return { rows, inner, edges, data, lines, by_line, subs, strings };
+}
+
+/**
+ * Appends strings to a region, tracking their byte offsets.
+ */
+class Strings {
+  constructor(base) {
+    this.list = [];
+    this.bytes = base;
+  }
+
+  add(str) {
+    const offset = this.bytes;
+    const length = Buffer.byteLength(str);
+    this.list.push(str);
+    this.bytes += length;
+    return [offset, length];
+  }
+}
+
+/**
+ * Lays an AST out into shared memory.
+ *
+ * @param {object} ast generated tree
+ * @return {SharedArrayBuffer}
+ */
+function share(ast) {
+  const rows = [];
+  const row_of = new Map();
+  const containers = [];
+
+  const visit = (node) => {
+    if (node && !row_of.has(node)) {
+      row_of.set(node, rows.length);
+      rows.push(node);
+    }
+  };
+
+  for (const type of C.TYPES) {
+    const nodes = ast[type] || {};
+    const first = rows.length;
+    if (type != C.MEMB) {
+      for (const id in nodes) {
+        visit(nodes[id]);
+      }
+    }
+    containers.push(first, rows.length - first);
+  }
+
+  // Members, and anything else only reached through inner lists
+  for (let r = 0; r < rows.length; r++) {
+    const inner = rows[r].inner;
+    if (inner) {
+      for (let i = 0; i < inner.length; i++) {
+        visit(inner[i]);
+      }
+    }
+  }
+
+  // Source lines lead the string region
+  const source = ast.source;
+  const line_offsets = new Int32Array(source.length + 1);
+  let bytes = 0;
+  for (let i = 0; i < source.length; i++) {
+    line_offsets[i] = bytes;
+    bytes += source[i] === undefined ? 0 : Buffer.byteLength(source[i]);
+  }
+  line_offsets[source.length] = bytes;
+
+  const strings = new Strings(bytes);
+  const cols = new Int32Array(rows.length * ROW);
+  const inner = [];
+  const edges = [];
+  const data = [];
+  const subs = [];
+
+  for (let r = 0; r < rows.length; r++) {
+    const node = rows[r];
+    const at = r * ROW;
+    const [line, sub] = split_id(node.id);
+
+    cols[at + R_LINE] = line;
+    cols[at + R_SUB] = sub;
+    cols[at + R_TAG] = C.TAG[node.type];
+
+    if (sub != NONE) {
+      subs.push([line, sub, r]);
+    }
+
+    if (node.parent === undefined) {
+      cols[at + R_PARENT] = ABSENT;
+      cols[at + R_PARENT_SUB] = NONE;
+    } else {
+      const [pline, psub] = split_id(node.parent);
+      cols[at + R_PARENT] = pline;
+      cols[at + R_PARENT_SUB] = psub;
+    }
+
+    cols[at + R_INNER] = inner.length;
+    if (node.inner) {
+      for (const item of node.inner) {
+        inner.push(item ? row_of.get(item) : NONE);
+      }
+      cols[at + R_INNER_LEN] = node.inner.length;
+    } else {
+      cols[at + R_INNER_LEN] = NONE;
+    }
+
+    cols[at + R_EDGES] = edges.length / EDGE;
+    for (const type in node.assocs) {
+      const tag = C.TAG[type];
+      for (const id of node.assocs[type]) {
+        const [eline, esub] = split_id(id);
+        edges.push(tag, eline, esub);
+      }
+    }
+    cols[at + R_EDGES_LEN] = edges.length / EDGE - cols[at + R_EDGES];
+
+    cols[at + R_DATA] = data.length / DATA;
+    let end = line;
+    for (const key in node.data) {
+      const lno = Number(key);
+      const text = node.data[key];
+      if (text === source[lno]) {
+        data.push(lno, NONE, 0);
+      } else {
+        data.push(lno, ...strings.add(text));
+      }
+      if (lno > end) {
+        end = lno;
+      }
+    }
+    cols[at + R_DATA_LEN] = data.length / DATA - cols[at + R_DATA];
+    cols[at + R_START] = line;
+    cols[at + R_END] = end;
+
+    if (node.decl) {
+      [cols[at + R_DECL], cols[at + R_DECL_LEN]] =
+        strings.add(JSON.stringify(node.decl));
+    } else {
+      cols[at + R_DECL] = NONE;
+    }
+  }
+
+  const types = ast.types && ast.types.size ?
+    strings.add(JSON.stringify(ast.types.names)) : [NONE, 0];
+
+  subs.sort((a, b) => a[0] - b[0] || a[1] - b[1]);
+
+  // Header
+  const h = new Int32Array(HEADER);
+  h[H_MAGIC] = MAGIC;
+  h[H_VERSION] = VERSION;
+  h[H_ROWS] = rows.length;
+  h[H_LINES] = source.length;
+  h[H_INNER] = inner.length;
+  h[H_EDGES] = edges.length / EDGE;
+  h[H_DATA] = data.length / DATA;
+  h[H_SUBS] = subs.length;
+  h[H_BYTES] = strings.bytes;
+  h[H_TYPES] = types[0];
+  h[H_TYPES_LEN] = types[1];
+  h.set(containers, H_CONTAINERS);
+
+  const at = layout(h);
+  const sab = new SharedArrayBuffer(at.strings * 4 + strings.bytes);
+  const words = new Int32Array(sab, 0, at.strings);
+
+  words.set(h, 0);
+  words.set(cols, at.rows);
+  words.set(inner, at.inner);
+  words.set(edges, at.edges);
+  words.set(data, at.data);
+  words.set(line_offsets, at.lines);
+
+  const by_line = words.subarray(at.by_line, at.by_line + source.length);
+  by_line.fill(NONE);
+  for (let r = rows.length - 1; r >= 0; r--) {
+    if (cols[r * ROW + R_SUB] == NONE) {
+      const line = cols[r * ROW + R_LINE];
+      // Top level nodes come first, and win over members
+      if (line >= 0 && line < source.length) {
+        by_line[line] = r;
+      }
+    }
+  }
+
+  for (let i = 0; i < subs.length; i++) {
+    words.set(subs[i], at.subs + i * SUB);
+  }
+
+  // String region
+  const region = Buffer.from(sab, at.strings * 4);
+  for (let i = 0; i < source.length; i++) {
+    if (source[i]) {
+      region.write(source[i], line_offsets[i]);
+    }
+  }
+  let offset = line_offsets[source.length];
+  for (const str of strings.list) {
+    offset += region.write(str, offset);
+  }
+
+  return sab;
+}
+
+/**
+ * Deep freezes decoded node data.
+ */
+function freeze(value) {
+  if (value && typeof value == 'object' && !Object.isFrozen(value)) {
+    Object.freeze(value);
+    for (const k in value) {
+      freeze(value[k]);
+    }
+  }
+  return value;
+}
+
+/**
+ * Read only view of an AST laid out by `share`.
+ * Mirrors the read api of a generated AST.
+ */
+class SharedAST {
+  /**
+   * @param {SharedArrayBuffer} sab as returned by share()
+   */
+  constructor(sab) {
+    const h = new Int32Array(sab, 0, HEADER);
+    if (h[H_MAGIC] != MAGIC || h[H_VERSION] != VERSION) {
+      throw new Error('Not a shared AST layout');
+    }
+
+    const at = layout(h);
+    this.buffer = sab;
+    this.words = new Int32Array(sab, 0, at.strings);
+    this.region = Buffer.from(sab, at.strings * 4);
+    this.at = at;
+    this.header = h;
+    this.nodes = new Array(h[H_ROWS]);
+
+    const types = new TypeTable();
+    if (h[H_TYPES] != NONE) {
+      for (const name of JSON.parse(this.text(h[H_TYPES], h[H_TYPES_LEN]))) {
+        types.intern(name);
+      }
+    }
+    Object.freeze(types.names);
+    this.types = Object.freeze(types);
+  }
+
+  text(offset, length) {
+    return this.region.toString('utf8', offset, offset + length);
+  }
+
+  /**
+   * Number of source lines.
+   * @return {number}
+   */
+  get lines() {
+    return this.header[H_LINES];
+  }
+
+  /**
+   * Source line by number.
+   *
+   * @param {number} lno line number
+   * @return {string}
+   */
+  line(lno) {
+    if (!(lno >= 0 && lno < this.lines)) {
+      return;
+    }
+    const base = this.at.lines + lno;
+    const start = this.words[base];
+    return this.text(start, this.words[base + 1] - start);
+  }
+
+  /**
+   * Keys of a container, in AST order.
+   *
+   * @param {string} container type of AST container.
+   * @return {array}
+   */
+  keys(container) {
+    const tag = C.TAG[container];
+    const first = this.header[H_CONTAINERS + tag * 2];
+    const count = this.header[H_CONTAINERS + tag * 2 + 1];
+    const keys = new Array(count);
+
+    for (let i = 0; i < count; i++) {
+      const at = this.at.rows + (first + i) * ROW;
+      keys[i] = String(join_id(this.words[at + R_LINE], this.words[at + R_SUB]));
+    }
+    return keys;
+  }
+
+  count(container) {
+    return { [container]: this.keys(container).length };
+  }
+
+  /**
+   * Row of a node id.
+   *
+   * @param {number|string} id
+   * @return {number} row, -1 when absent
+   */
+  row(id) {
+    const [line, sub] = split_id(id);
+    if (sub == NONE) {
+      return line >= 0 && line < this.lines ?
+        this.words[this.at.by_line + line] : NONE;
+    }
+
+    let lo = 0;
+    let hi = this.header[H_SUBS] - 1;
+    while (lo <= hi) {
+      const mid = (lo + hi) >> 1;
+      const at = this.at.subs + mid * SUB;
+      const cmp = this.words[at] - line || this.words[at + 1] - sub;
+      if (cmp == 0) {
+        return this.words[at + 2];
+      }
+      if (cmp < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    return NONE;
+  }
+
+  /**
+   * Node lookup by id, including struct members.
+   *
+   * @param {number|string} id of the node
+   * @return {object|undefined} frozen node
+   */
+  node(id) {
+    const row = this.row(id);
+    return row == NONE ? undefined : this.decode(row);
+  }
+
+  /**
+   * Inner elements of a node, optionally filtered by type.
+   *
+   * @param {number} pid Id of the node
+   * @param {string|optional} type of the inner nodes returned.
+   * @return {Array}
+   */
+  inner(pid, type) {
+    const n = this.node(pid);
+    return (n.inner || []).filter((item) => !type || (item && item.type == type));
+  }
+
+  /**
+   * First and last line of a node.
+   *
+   * @param {number|string} id
+   * @return {array|undefined} [start, end]
+   */
+  span(id) {
+    const row = this.row(id);
+    if (row == NONE) {
+      return;
+    }
+    const at = this.at.rows + row * ROW;
+    return [this.words[at + R_START], this.words[at + R_END]];
+  }
+
+  /**
+   * Decodes a node row, shaped as the Node it was laid out from.
+   */
+  decode(row) {
+    if (this.nodes[row]) {
+      return this.nodes[row];
+    }
+
+    const w = this.words;
+    const at = this.at.rows + row * ROW;
+
+    const assocs = {};
+    const edges = this.at.edges + w[at + R_EDGES] * EDGE;
+    for (let i = 0; i < w[at + R_EDGES_LEN]; i++) {
+      const e = edges + i * EDGE;
+      const type = C.TYPES[w[e]];
+      (assocs[type] || (assocs[type] = [])).push(join_id(w[e + 1], w[e + 2]));
+    }
+
+    const data = {};
+    const entries = this.at.data + w[at + R_DATA] * DATA;
+    for (let i = 0; i < w[at + R_DATA_LEN]; i++) {
+      const d = entries + i * DATA;
+      data[w[d]] = w[d + 1] == NONE ? this.line(w[d]) :
+        this.text(w[d + 1], w[d + 2]);
+    }
+
+    let inner;
+    let index;
+    if (w[at + R_INNER_LEN] != NONE) {
+      inner = [];
+      index = {};
+      const list = this.at.inner + w[at + R_INNER];
+      for (let i = 0; i < w[at + R_INNER_LEN]; i++) {
+        const item = w[list + i] == NONE ? undefined : this.decode(w[list + i]);
+        inner.push(item);
+        if (item) {
+          index[item.id] = { ind: i, type: item.type };
+        }
+      }
+    }
+
+    const node = {
+      id: join_id(w[at + R_LINE], w[at + R_SUB]),
+      type: C.TYPES[w[at + R_TAG]],
+      assocs,
+      data,
+      parent: w[at + R_PARENT] == ABSENT ? undefined :
+        join_id(w[at + R_PARENT], w[at + R_PARENT_SUB]),
+      inner,
+      index,
+      decl: w[at + R_DECL] == NONE ? undefined :
+        JSON.parse(this.text(w[at + R_DECL], w[at + R_DECL_LEN])),
+    };
+
+    this.nodes[row] = freeze(node);
+    return node;
+  }
+}
+
+module.exports = {
+  share,
+  SharedAST,
+};
@@ -0,0 +1,606 @@
+/**
+ * @fileOverview
+ * Immutable, versioned AST snapshots.
+ *
+ * A SnapshotStore publishes parsed ASTs as frozen Snapshot versions.
+ * Containers, the line index and the source are persistent maps, so a new
+ * version shares every unchanged node and trie branch with the previous
+ * one. Readers hold on to whichever version they started with and never
+ * observe a later publish; versions no longer referenced by any reader
+ * are reclaimed by the garbage collector.
+ *
+ * @name snapshot.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const PersistentMap = require('./hamt').PersistentMap;
+const logger = require('./utils').logger;
+const C = require('./constants');
+const serializer = require('./serializer');
+
+/**
+ * Utility log namespaced helper
+ */
+const log = logger('snapshot');
+
+/**
+ * Node containers held by a snapshot.
+ */
+const CONTAINERS = [C.COMM, C.CODE, C.DEF, C.CHAR, C.SKIP];
+
+/**
+ * Type names of snapshots without member declarations.
+ */
+const NO_TYPES = Object.freeze([]);
+
+/**
+ * Structural equality of plain AST data.
+ *
+ * @param {*} a
+ * @param {*} b
+ * @return {boolean}
+ */
+function equal(a, b) {
+  if (a === b) {
+    return true;
+  }
+
+  if (!a || !b || typeof a != 'object' || typeof b != 'object' ||
+    Array.isArray(a) != Array.isArray(b)) {
+    return false;
+  }
+
+  const keys = Object.keys(a);
+  if (keys.length != Object.keys(b).length) {
+    return false;
+  }
+
+  for (const k of keys) {
+    if (!Object.prototype.hasOwnProperty.call(b, k) || !equal(a[k], b[k])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Freezes AST data in place, along with everything it references.
+ *
+ * @param {*} value node, index entry or nested data
+ * @return {*} the frozen value
+ */
+function freeze(value) {
+  if (value && typeof value == 'object' && !Object.isFrozen(value)) {
+    Object.freeze(value);
+    for (const k of Object.keys(value)) {
+      freeze(value[k]);
+    }
+  }
+  return value;
+}
+
+/**
+ * Brings a persistent map in line with a plain object, keeping the
+ * previous value of every entry that is structurally unchanged.
+ *
+ * @param {PersistentMap} map previous version
+ * @param {object|array} obj current entries
+ * @return {PersistentMap} updated map
+ */
+function sync(map, obj) {
+  let next = map;
+  let count = 0;
+  let added = false;
+
+  for (const key in obj) {
+    const value = obj[key];
+    const prev = map.get(key);
+    count++;
+    added = added || prev === undefined;
+
+    if (prev === undefined || !equal(prev, value)) {
+      next = next.set(key, freeze(value));
+    }
+  }
+
+  // Entries gone from the current object
+  if (next.size > count) {
+    for (const key of map.keys()) {
+      if (!Object.prototype.hasOwnProperty.call(obj, key)) {
+        next = next.delete(key);
+      }
+    }
+  } else if (!added) {
+    same_keys(map, next);
+  }
+
+  return next;
+}
+
+/**
+ * Canonical array index keys sort first, like object integer keys.
+ */
+function is_index(key) {
+  return /^(0|[1-9]\d*)$/.test(key) && Number(key) < 0xffffffff;
+}
+
+/**
+ * Keys of persistent maps in AST order. Maps never change, so keys are
+ * sorted once per map, each key being classified once.
+ */
+const SORTED = new WeakMap();
+
+function sorted_keys(map) {
+  let keys = SORTED.get(map);
+  if (!keys) {
+    keys = Array.from(map.keys(), (key) =>
+      ({ key, index: is_index(key), num: parseFloat(key) }))
+      .sort((a, b) => a.index != b.index ? (a.index ? -1 : 1) : a.num - b.num)
+      .map((entry) => entry.key);
+    SORTED.set(map, Object.freeze(keys));
+  }
+  return keys;
+}
+
+/**
+ * Comment nodes extracted from the members of a node, which are held in
+ * the comments container alongside top level comments.
+ *
+ * @param {object} node definition node
+ * @return {array}
+ */
+function member_comments(node) {
+  const comments = [];
+  for (const item of node.inner || []) {
+    if (item && item.type == C.MEMB) {
+      for (const sub of item.inner || []) {
+        if (sub && sub.type == C.COMM) {
+          comments.push(sub);
+        }
+      }
+    }
+  }
+  return comments;
+}
+
+/**
+ * Keys of the line index held by a node: its own lines, its members, and
+ * the comments extracted from them.
+ *
+ * @param {PersistentMap} index line index
+ * @param {object} node
+ * @return {array} keys
+ */
+function owned_keys(index, node) {
+  const keys = [];
+  const own = (key, id) => {
+    const entry = index.get(key);
+    if (entry && entry.node_id == id) {
+      keys.push(String(key));
+    }
+  };
+
+  own(node.id, node.id);
+  for (const lno in node.data) {
+    own(lno, node.id);
+  }
+  for (const item of node.inner || []) {
+    if (item && item.type == C.MEMB) {
+      own(item.id, item.id);
+    }
+  }
+  for (const comment of member_comments(node)) {
+    own(comment.id, comment.id);
+  }
+  return keys;
+}
+
+/**
+ * Index entries of a node, shaped as the parser writes them: one per
+ * line of the node, one per member, and one per comment extracted from a
+ * member.
+ *
+ * @param {string} type container of the node
+ * @param {number|string} id key the node is held under
+ * @param {object} node
+ * @return {Map} entries by key
+ */
+function index_entries(type, id, node) {
+  const entries = new Map();
+  entries.set(String(id), { node_id: node.id, type, sub: [] });
+  for (const lno in node.data) {
+    if (is_index(lno)) {
+      entries.set(lno, { node_id: node.id, type, sub: [] });
+    }
+  }
+
+  const members = node.inner || [];
+  for (let ind = 0; ind < members.length; ind++) {
+    const item = members[ind];
+    if (!item || item.type != C.MEMB) {
+      continue;
+    }
+
+    entries.set(String(item.id), {
+      node_id: item.id, type: C.MEMB, sub: [], parent: node.id, ind
+    });
+
+    const subs = item.inner || [];
+    for (let sub = 0; sub < subs.length; sub++) {
+      if (subs[sub] && subs[sub].type == C.COMM) {
+        entries.set(String(subs[sub].id), {
+          node_id: subs[sub].id, type: C.COMM, parent: item.id, ind: sub
+        });
+      }
+    }
+  }
+  return entries;
+}
+
+/**
+ * Persistent map with keys dropped and entries set. Values structurally
+ * equal to those already held are kept, and so are the sorted keys when
+ * no key comes or goes.
+ *
+ * @param {PersistentMap} map previous version
+ * @param {array} drops keys to drop, unless set
+ * @param {Map} entries values to set, by key
+ * @return {PersistentMap} updated map
+ */
+function patch(map, drops, entries) {
+  let next = map;
+  for (const key of drops) {
+    if (!entries.has(key)) {
+      next = next.delete(key);
+    }
+  }
+
+  let added = false;
+  for (const [key, value] of entries) {
+    const prev = next.get(key);
+    added = added || prev === undefined;
+    if (prev === undefined || !equal(prev, value)) {
+      next = next.set(key, freeze(value));
+    }
+  }
+
+  if (!added && next.size == map.size) {
+    same_keys(map, next);
+  }
+  return next;
+}
+
+/**
+ * Moves the member comments and index entries of a node from its
+ * previous version to its next one, in containers being derived. Either
+ * version may be missing, when the node is added or removed.
+ *
+ * @param {object} nodes containers being derived, updated in place
+ * @param {PersistentMap|null} index line index
+ * @param {object|undefined} prev outgoing node
+ * @param {object|undefined} node incoming node
+ * @param {string} type container of the node
+ * @param {number|string} id key the node is held under
+ * @return {PersistentMap|null} updated index
+ */
+function relink(nodes, index, prev, node, type, id) {
+  const key = (item) => String(item.id);
+
+  const comments = new Map();
+  for (const comment of node ? member_comments(node) : []) {
+    comments.set(key(comment), comment);
+  }
+  nodes[C.COMM] = patch(nodes[C.COMM],
+    prev ? member_comments(prev).map(key) : [], comments);
+
+  if (!index) {
+    return null;
+  }
+  return patch(index, prev ? owned_keys(index, prev) : [],
+    node ? index_entries(type, id, node) : new Map());
+}
+
+/**
+ * Records that a map derived from another holds the same keys.
+ */
+function same_keys(prev, next) {
+  const keys = SORTED.get(prev);
+  if (keys && next !== prev) {
+    SORTED.set(next, keys);
+  }
+}
+
+/**
+ * JSON of a persistent map, as the plain object it stands for would be
+ * written. Maps and the values they hold are immutable, so the JSON of
+ * both is reused across serializations; a map derived from another only
+ * writes the values it does not share.
+ */
+function write_map(map, depth, compact) {
+  const keys = sorted_keys(map);
+  const parts = new Array(keys.length);
+  for (let i = 0; i < keys.length; i++) {
+    parts[i] = serializer.fragment(map.get(keys[i]), depth + 1, compact);
+  }
+  return serializer.object(keys, parts, depth, compact);
+}
+
+function map_json(map, depth, compact) {
+  return serializer.cached(map, depth, compact, write_map);
+}
+
+/**
+ * A frozen version of an AST.
+ * Mirrors the read api of a generated AST.
+ */
+class Snapshot {
+  /**
+   * @param {number} version sequence number
+   * @param {object} nodes persistent map per container
+   * @param {PersistentMap|null} index line index, null when not built
+   * @param {PersistentMap} source lines by line number
+   * @param {array|optional} types interned member type names
+   */
+  constructor(version, nodes, index, source, types = NO_TYPES) {
+    this.version = version;
+    this.nodes = Object.freeze(nodes);
+    this.index = index;
+    this.source = source;
+    this.types = types;
+    Object.freeze(this);
+  }
+
+  /**
+   * Keys of a container, in AST order.
+   *
+   * @param {string} container type of AST container.
+   * @return {array}
+   */
+  keys(container) {
+    return sorted_keys(this.nodes[container]).slice();
+  }
+
+  /**
+   * Number of source lines.
+   * @return {number}
+   */
+  get lines() {
+    return this.source.size;
+  }
+
+  /**
+   * Source line by number.
+   *
+   * @param {number} lno line number
+   * @return {string}
+   */
+  line(lno) {
+    return this.source.get(lno);
+  }
+
+  /**
+   * Node lookup by id, including struct members.
+   *
+   * @param {number|string} id of the node
+   * @return {object|undefined} node
+   */
+  node(id) {
+    if (!this.index) {
+      for (const type of CONTAINERS) {
+        const found = this.nodes[type].get(id);
+        if (found) {
+          return found;
+        }
+      }
+      return;
+    }
+
+    const index = this.index.get(id);
+    if (!index) {
+      log.error(`node(${id}) not found in the index`);
+      return;
+    }
+
+    if (index.type == C.MEMB) {
+      return this.node(index.parent).inner[index.ind];
+    }
+
+    return this.nodes[index.type].get(id);
+  }
+
+  /**
+   * Inner elements of a node, optionally filtered by type.
+   *
+   * @param {number} pid Id of the node
+   * @param {string|optional} type of the inner nodes returned.
+   * @return {Array}
+   */
+  inner(pid, type) {
+    const n = this.node(pid);
+    return (n.inner || []).filter((item) => !type || (item && item.type == type));
+  }
+
+  /**
+   * Snapshot with a node set, sharing everything else.
+   * Index entries and member comments of the node it replaces are
+   * dropped, and those of the new node added.
+   *
+   * Comments extracted from members keep the index entry of their
+   * member when set on their own.
+   *
+   * @param {string} container type of AST container.
+   * @param {number|string} id node id
+   * @param {object} node replacement node
+   * @return {Snapshot}
+   */
+  set(container, id, node) {
+    const prev = this.nodes[container].get(id);
+    if (prev === node) {
+      return this;
+    }
+
+    const nodes = Object.assign({}, this.nodes);
+    nodes[container] = nodes[container].set(id, freeze(node));
+    if (prev && nodes[container].size == this.nodes[container].size) {
+      same_keys(this.nodes[container], nodes[container]);
+    }
+
+    const index = node.parent === undefined ?
+      relink(nodes, this.index, prev, node, container, id) : this.index;
+
+    return new Snapshot(this.version + 1, nodes, index, this.source,
+      this.types);
+  }
+
+  /**
+   * Snapshot without a node, sharing everything else.
+   * Index entries of the node's lines and members go along with it, as
+   * do the comments extracted from its members.
+   *
+   * @param {string} container type of AST container.
+   * @param {number|string} id node id
+   * @return {Snapshot}
+   */
+  remove(container, id) {
+    const node = this.nodes[container].get(id);
+    if (!node) {
+      return this;
+    }
+
+    const nodes = Object.assign({}, this.nodes);
+    nodes[container] = nodes[container].delete(id);
+    const index = relink(nodes, this.index, node, undefined, container, id);
+    return new Snapshot(this.version + 1, nodes, index, this.source,
+      this.types);
+  }
+
+  /**
+   * Serializes the snapshot exactly as `ast.json()` would.
+   * Output of nodes and index entries shared with the version serialized
+   * before in the same mode is reused.
+   *
+   * @param {object|optional} opts { compact }
+   * @return {string}
+   */
+  json(opts = {}) {
+    const compact = !!opts.compact;
+    serializer.begin(compact);
+
+    const types = [];
+    const nodes = [];
+    for (const type of CONTAINERS) {
+      // Disabled regions are only listed when found
+      if (type != C.SKIP || this.nodes[type].size) {
+        types.push(type);
+        nodes.push(map_json(this.nodes[type], 2, compact));
+      }
+    }
+
+    const keys = ['nodes'];
+    const parts = [serializer.object(types, nodes, 1, compact)];
+
+    if (this.types.length) {
+      keys.push('types');
+      parts.push(serializer.fragment(this.types, 1, compact));
+    }
+
+    if (this.index) {
+      keys.push('index');
+      parts.push(map_json(this.index, 1, compact));
+    }
+
+    return serializer.object(keys, parts, 0, compact);
+  }
+}
+
+/**
+ * Derives the next snapshot version from a freshly generated AST.
+ *
+ * Nodes entering the snapshot are frozen in place. Nodes structurally
+ * equal to the previous version are left out, the previous node is
+ * shared instead. Every node, index entry and source line is compared,
+ * so this is a full diff costing a pass over the whole AST.
+ *
+ * @param {Snapshot} prev previous version
+ * @param {object} ast generated tree
+ * @return {Snapshot}
+ */
+function derive(prev, ast) {
+  const nodes = {};
+  for (const type of CONTAINERS) {
+    nodes[type] = sync(prev.nodes[type], ast[type]);
+  }
+
+  const index = ast.index ?
+    sync(prev.index || PersistentMap.empty(), ast.index) : null;
+
+  // Type tables only ever grow, unchanged ones are shared
+  const names = ast.types ? ast.types.names : NO_TYPES;
+  const types = names.length == prev.types.length ? prev.types :
+    Object.freeze(names.slice());
+
+  return new Snapshot(prev.version + 1, nodes, index,
+    sync(prev.source, ast.source), types);
+}
+
+/**
+ * Empty initial version.
+ */
+const EMPTY = new Snapshot(0, {
+  [C.COMM]: PersistentMap.empty(),
+  [C.CODE]: PersistentMap.empty(),
+  [C.DEF]: PersistentMap.empty(),
+  [C.CHAR]: PersistentMap.empty(),
+  [C.SKIP]: PersistentMap.empty(),
+}, PersistentMap.empty(), PersistentMap.empty());
+
+/**
+ * Holds the latest published snapshot.
+ * Only the current version is retained by the store itself.
+ */
+class SnapshotStore {
+  constructor() {
+    this.current = EMPTY;
+  }
+
+  /**
+   * Publishes a generated AST as the next version.
+   * The AST must not be mutated afterwards.
+   *
+   * The whole AST is diffed against the current version, whatever the
+   * size of the change. Use `update` when the changed nodes are known.
+   *
+   * @param {object} ast generated tree
+   * @return {Snapshot} published version
+   */
+  publish(ast) {
+    this.current = derive(this.current, ast);
+    return this.current;
+  }
+
+  /**
+   * Publishes a version derived from the current one, eg. through
+   * `set` and `remove`, when the changed nodes are already known.
+   * This is the incremental path: its cost is proportional to the nodes
+   * changed rather than to the size of the AST.
+   *
+   * @param {function} fn given the current snapshot, returns the next.
+   * @return {Snapshot} published version
+   */
+  update(fn) {
+    const next = fn(this.current);
+    if (next !== this.current) {
+      this.current = next;
+    }
+    return this.current;
+  }
+}
+
+module.exports = {
+  Snapshot,
+  SnapshotStore,
+  freeze,
+  equal,
+};
@@ -0,0 +1,213 @@
+/**
+ * @fileOverview
+ * Parser state machine layout.
+ *
+ * Scope presence is tracked as a bitmask of node tags, and the current
+ * and previous node ids of each kind live in fixed integer slots indexed
+ * by tag. Nothing in here is reallocated while lines are processed.
+ *
+ * @name state.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const C = require('./constants');
+const Scan = require('./classifier').Scan;
+
+/**
+ * Slot indices, equal to the node type tags.
+ */
+const COMM = C.TAG[C.COMM];
+const CODE = C.TAG[C.CODE];
+const DEF = C.TAG[C.DEF];
+const MEMB = C.TAG[C.MEMB];
+const CHAR = C.TAG[C.CHAR];
+const SKIP = C.TAG[C.SKIP];
+
+/**
+ * Scope bits, one per slot.
+ */
+const IN_COMM = 1 << COMM;
+const IN_CODE = 1 << CODE;
+const IN_DEF = 1 << DEF;
+const IN_MEMB = 1 << MEMB;
+const IN_CHAR = 1 << CHAR;
+const IN_SKIP = 1 << SKIP;
+
+/**
+ * Empty slot marker.
+ */
+const NONE = -1;
+
+/**
+ * Number of slots, one per node tag.
+ */
+const SLOTS = C.TYPES.length;
+
+/**
+ * Association reference tag of each node tag.
+ */
+const REF = new Int8Array(SLOTS);
+REF[COMM] = CODE;
+REF[CODE] = COMM;
+REF[MEMB] = DEF;
+REF[DEF] = COMM;
+REF[CHAR] = COMM;
+REF[SKIP] = COMM;
+
+/**
+ * Container tag each node tag is stored in.
+ */
+const CONTAINER = new Int8Array(SLOTS);
+CONTAINER[COMM] = COMM;
+CONTAINER[CODE] = CODE;
+CONTAINER[MEMB] = DEF;
+CONTAINER[DEF] = DEF;
+CONTAINER[CHAR] = CHAR;
+CONTAINER[SKIP] = SKIP;
+
+/**
+ * Every node kind.
+ */
+const ALL = IN_COMM | IN_CODE | IN_DEF | IN_MEMB | IN_CHAR | IN_SKIP;
+
+/**
+ * Extraction profile names, accepted by the `only` option.
+ */
+const KINDS = {
+  [C.COMM]: IN_COMM,
+  comment: IN_COMM,
+  [C.CODE]: IN_CODE,
+  [C.DEF]: IN_DEF,
+  def: IN_DEF,
+  [C.MEMB]: IN_MEMB | IN_DEF,
+  member: IN_MEMB | IN_DEF,
+  [C.CHAR]: IN_CHAR,
+  chars: IN_CHAR,
+  [C.SKIP]: IN_SKIP,
+};
+
+/**
+ * Resolves the node kinds to be extracted.
+ *
+ * Options:
+ *   only    - kinds to build, as an array or comma separated string.
+ *   members - false to skip struct members (and their inner comments).
+ *
+ * Members are built alongside definitions unless excluded.
+ *
+ * @param {object} opts generation options
+ * @return {number} bitmask of wanted kinds
+ */
+function profile(opts = {}) {
+  let want = ALL;
+
+  if (opts.only) {
+    const names = Array.isArray(opts.only) ? opts.only :
+      String(opts.only).split(',');
+
+    want = 0;
+    for (let name of names) {
+      name = name.trim();
+      if (!KINDS.hasOwnProperty(name)) {
+        throw new Error(`Unknown node kind in extraction profile: ${name}`);
+      }
+      want |= KINDS[name];
+    }
+
+    if (want & IN_DEF) {
+      want |= IN_MEMB;
+    }
+  }
+
+  if (opts.members === false || !(want & IN_DEF)) {
+    want &= ~IN_MEMB;
+  }
+
+  return want;
+}
+
+/**
+ * Creates an empty slot array.
+ * @return {Int32Array}
+ */
+function slots() {
+  return new Int32Array(SLOTS).fill(NONE);
+}
+
+/**
+ * Creates an empty State object
+ * @param {object} opts generation options
+ * @return {object} Fresh state
+ */
+function create_state(opts = {}) {
+  const want = profile(opts);
+
+  // Definitions and chars may still turn into code further down,
+  // so they are built provisionally whenever code is wanted.
+  const build = want | (want & IN_CODE ? IN_DEF | IN_CHAR : 0);
+
+  return {
+    // Scope presence bitmasks
+    inside: 0,
+    closing: 0,
+
+    // Node id slots, indexed by tag
+    current: slots(),
+    previous: slots(),
+
+    // Scope depth tracking
+    depth: 0,
+    lno: -1,
+
+    // Per line scratch
+    node: null,
+    block_start: false,
+    current_line: '',
+    ln: '',
+    scan: new Scan(),
+
+    // Extraction profile
+    want: want,
+    build: build,
+    indexed: opts.index !== false,
+    // Member declarations are decomposed on request, or along with a
+    // shared type table
+    decls: !!(opts.decl || opts.types),
+
+    // Line ownership for lookbehind: node id and tag per line
+    line_node: [],
+    line_tag: [],
+
+    // Holders for provisional nodes of unwanted kinds
+    scratch: C.TYPES.map(() => ({})),
+
+    // Optional node arena shared between parses
+    pool: opts.pool || null,
+
+    // Preprocessor front stage, when enabled
+    pp: null,
+  };
+}
+
+module.exports = {
+  COMM,
+  CODE,
+  DEF,
+  MEMB,
+  CHAR,
+  SKIP,
+  IN_COMM,
+  IN_CODE,
+  IN_DEF,
+  IN_MEMB,
+  IN_CHAR,
+  IN_SKIP,
+  NONE,
+  ALL,
+  SLOTS,
+  REF,
+  CONTAINER,
+  profile,
+  create_state,
+};
@@ -0,0 +1,390 @@
+/**
+ * @fileOverview
+ * Project wide symbol index.
+ *
+ * Functions, structs and enums found across a source tree are recorded
+ * into an on-disk JSON database, keyed by file, along with the places
+ * each name is declared at. Rebuilds only re-parse files whose mtime and
+ * size changed, and whose content hash differs.
+ *
+ * @name symbols.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+
+const logger = require('./utils').logger;
+const ast_from_file = require('./abstractor').ast_from_file;
+const C = require('./constants');
+
+/**
+ * Utility log namespaced helper
+ */
+const log = logger('symbols');
+
+/**
+ * Database format version, bumped whenever the symbol layout changes.
+ */
+const VERSION = 2;
+
+/**
+ * Default database file name, stored at the root of the indexed tree.
+ */
+const DB_NAME = '.c-ast-index.json';
+
+/**
+ * Source file extensions picked up while walking a tree.
+ */
+const EXTENSIONS = ['.c', '.h'];
+
+/**
+ * Extensions of compressed sources, eg. `foo.c.gz`, parsed decompressed.
+ */
+const COMPRESSED = ['.gz', '.br'];
+
+/**
+ * Extraction profile: only the nodes symbols are derived from.
+ */
+const PROFILE = {
+  only: [C.COMM, C.CODE, C.DEF],
+  members: false,
+  index: false,
+};
+
+const DEF_NAME = /\b(struct|enum)\s+([A-Za-z_]\w*)/;
+const TYPEDEF_NAME = /}\s*([A-Za-z_]\w*)\s*;/;
+
+/**
+ * Databases loaded by path, along with the file stat they were read at.
+ */
+const LOADED = new Map();
+
+/**
+ * Default database location for a tree.
+ *
+ * @param {string} dir root of the indexed tree
+ * @return {string} database path
+ */
+function db_path(dir) {
+  return path.join(path.resolve(dir), DB_NAME);
+}
+
+/**
+ * Creates an empty database.
+ *
+ * @param {string|null} root indexed tree
+ * @return {object} database
+ */
+function create_db(root) {
+  // Any symbol name may be a key, `__proto__` included
+  return {
+    version: VERSION, root: root, files: {}, names: Object.create(null)
+  };
+}
+
+/**
+ * Whether a file still has the stat a database was read or written at.
+ */
+function same_stat(a, b) {
+  return a.mtimeMs === b.mtimeMs && a.size === b.size && a.ino === b.ino;
+}
+
+/**
+ * Loads a symbol database, or an empty one when missing or outdated.
+ * A database is only parsed again once its file changed.
+ *
+ * @param {string} file database path
+ * @return {object} database
+ */
+function load(file) {
+  try {
+    const stat = fs.statSync(file);
+    const loaded = LOADED.get(file);
+    if (loaded && same_stat(loaded.stat, stat)) {
+      return loaded.db;
+    }
+
+    const db = JSON.parse(fs.readFileSync(file, 'utf8'));
+    if (db.version === VERSION && db.files && db.names) {
+      LOADED.set(file, { stat, db });
+      return db;
+    }
+  } catch (err) {
+    if (err.code != 'ENOENT') {
+      log.error(`Discarding unreadable symbol index: ${file}`);
+    }
+  }
+
+  return create_db(null);
+}
+
+/**
+ * Writes a database atomically, so readers never see a partial file.
+ *
+ * @param {string} file database path
+ * @param {object} db database
+ */
+function save(file, db) {
+  const tmp = `${file}.${process.pid}.tmp`;
+  fs.writeFileSync(tmp, JSON.stringify(db));
+  fs.renameSync(tmp, file);
+  LOADED.set(file, { stat: fs.statSync(file), db });
+}
+
+/**
+ * Recursively lists source files, skipping hidden folders.
+ *
+ * @param {string} dir folder to walk
+ * @param {array} out collected absolute paths
+ * @return {array} source files
+ */
+function walk(dir, out = []) {
+  for (const entry of fs.readdirSync(dir, { withFileTypes: true })) {
+    if (entry.name[0] == '.' || entry.name == 'node_modules') {
+      continue;
+    }
+
+    const full = path.join(dir, entry.name);
+    if (entry.isDirectory()) {
+      walk(full, out);
+    } else if (entry.isFile() && is_source(entry.name)) {
+      out.push(full);
+    }
+  }
+
+  return out;
+}
+
+/**
+ * Whether a file name is that of a source file, compressed or not.
+ */
+function is_source(name) {
+  let ext = path.extname(name);
+  if (COMPRESSED.indexOf(ext) >= 0) {
+    ext = path.extname(path.basename(name, ext));
+  }
+  return EXTENSIONS.indexOf(ext) >= 0;
+}
+
+/**
+ * Content hash of a file.
+ *
+ * @param {string} file path
+ * @return {string} hex digest
+ */
+function hash(file) {
+  return crypto.createHash('sha1').update(fs.readFileSync(file)).digest('hex');
+}
+
+/**
+ * Line span of a node, from its data line numbers.
+ *
+ * @param {object} node AST node
+ * @return {array} first and last line
+ */
+function span(node) {
+  const lines = Object.keys(node.data);
+  return [parseInt(lines[0]), parseInt(lines[lines.length - 1])];
+}
+
+/**
+ * Builds a symbol entry.
+ */
+function symbol(name, kind, node) {
+  const lines = span(node);
+  const comments = node.assocs[C.COMM];
+
+  return {
+    name: name,
+    kind: kind,
+    id: node.id,
+    start: lines[0],
+    end: lines[1],
+    comment: comments && comments.length ? comments[0] : null,
+  };
+}
+
+const is_word = (c) => c == 95 || (c >= 48 && c <= 57) ||
+  (c >= 65 && c <= 90) || (c >= 97 && c <= 122);
+const is_space = (c) => c == 32 || (c >= 9 && c <= 13);
+
+/**
+ * First identifier directly preceding a call or declaration parenthesis,
+ * ignoring function pointer declarators. Scanned rather than matched, as
+ * a regular expression backtracks over every long run of word characters
+ * without a parenthesis, such as those of minified or generated lines.
+ *
+ * @param {string} text
+ * @return {string|null}
+ */
+function function_name(text) {
+  for (let paren = text.indexOf('('); paren >= 0;
+    paren = text.indexOf('(', paren + 1)) {
+    let next = paren + 1;
+    while (next < text.length && is_space(text.charCodeAt(next))) {
+      next++;
+    }
+    if (text[next] == '*') {
+      continue;
+    }
+
+    let end = paren;
+    while (end > 0 && is_space(text.charCodeAt(end - 1))) {
+      end--;
+    }
+    let start = end;
+    while (start > 0 && is_word(text.charCodeAt(start - 1))) {
+      start--;
+    }
+    // Identifiers do not start with a digit
+    while (start < end && text.charCodeAt(start) <= 57) {
+      start++;
+    }
+    if (start < end) {
+      return text.slice(start, end);
+    }
+  }
+  return null;
+}
+
+/**
+ * Derives the symbols declared by an AST.
+ *
+ * @param {object} ast tree generated with the symbol profile
+ * @return {array} symbol entries
+ */
+function extract(ast) {
+  const symbols = [];
+
+  for (const id of ast.keys(C.CODE)) {
+    const node = ast[C.CODE][id];
+    const text = Object.values(node.data).join(' ');
+    const name = function_name(text);
+
+    if (name) {
+      symbols.push(symbol(name, 'function', node));
+    }
+  }
+
+  for (const id of ast.keys(C.DEF)) {
+    const node = ast[C.DEF][id];
+    const lines = Object.values(node.data);
+    const match = DEF_NAME.exec(lines[0]);
+    const kind = match ? match[1] : C.DEF;
+
+    if (match) {
+      symbols.push(symbol(match[2], kind, node));
+    }
+
+    // typedef struct x { ... } name;
+    if (lines[0].indexOf('typedef') >= 0) {
+      const alias = TYPEDEF_NAME.exec(lines[lines.length - 1]);
+      if (alias && (!match || alias[1] != match[2])) {
+        symbols.push(symbol(alias[1], kind, node));
+      }
+    }
+  }
+
+  return symbols;
+}
+
+/**
+ * Builds or refreshes the symbol index of a source tree.
+ *
+ * Options:
+ *   db - database path, defaults to `.c-ast-index.json` inside dir.
+ *
+ * @param {string} dir root of the tree to index
+ * @param {object} opts index options
+ * @return {object} rebuild statistics
+ */
+async function build(dir, opts = {}) {
+  const root = path.resolve(dir);
+  const file = opts.db ? path.resolve(opts.db) : db_path(root);
+  const prev = load(file);
+  const reuse = prev.root === root ? prev.files : {};
+
+  const db = create_db(root);
+  const stats = { files: 0, parsed: 0, reused: 0, removed: 0, symbols: 0 };
+
+  for (const full of walk(root)) {
+    const rel = path.relative(root, full);
+    const stat = fs.statSync(full);
+    const mtime = stat.mtimeMs;
+    let entry = reuse[rel];
+
+    if (entry && entry.mtime === mtime && entry.size === stat.size) {
+      stats.reused++;
+    } else {
+      const digest = hash(full);
+
+      if (entry && entry.hash === digest) {
+        // Touched but unchanged
+        entry = Object.assign({}, entry, { mtime: mtime, size: stat.size });
+        stats.reused++;
+      } else {
+        const ast = await ast_from_file(full, PROFILE);
+        if (!ast) {
+          continue;
+        }
+
+        entry = {
+          mtime: mtime,
+          size: stat.size,
+          hash: digest,
+          symbols: extract(ast),
+        };
+        stats.parsed++;
+      }
+    }
+
+    db.files[rel] = entry;
+    entry.symbols.forEach((sym, i) => {
+      const refs = db.names[sym.name] || (db.names[sym.name] = []);
+      refs.push([rel, i]);
+    });
+    stats.files++;
+    stats.symbols += entry.symbols.length;
+  }
+
+  for (const rel in reuse) {
+    if (!db.files[rel]) {
+      stats.removed++;
+    }
+  }
+
+  save(file, db);
+  return stats;
+}
+
+/**
+ * Looks up a symbol by name, without parsing any source.
+ *
+ * Options:
+ *   db - database path, defaults to `.c-ast-index.json` inside dir.
+ *   dir - indexed tree, defaults to the working directory.
+ *
+ * @param {string} name symbol name
+ * @param {object} opts lookup options
+ * @return {array} matches, each a symbol entry with its absolute file
+ */
+function lookup(name, opts = {}) {
+  const file = opts.db ? path.resolve(opts.db) : db_path(opts.dir || '.');
+  const db = load(file);
+  if (!Object.prototype.hasOwnProperty.call(db.names, name)) {
+    return [];
+  }
+
+  return db.names[name].map(([rel, i]) =>
+    Object.assign({ file: path.join(db.root, rel) }, db.files[rel].symbols[i]));
+}
+
+module.exports = {
+  DB_NAME,
+  build,
+  lookup,
+  extract,
+};
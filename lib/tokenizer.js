@@ -2,6 +2,11 @@
  * @fileOverview
  * Parses lines into tokenized state markers.
  *
+ * Token detection is a table driven state machine: the open scopes, the
+ * classified line features and the root depth index a precomputed
+ * transition, which encodes the next scope bitmask along with the slots
+ * to open or close for the line.
+ *
  * @name tokenizer.js
  * @author Bailey Cosier <bailey@cosier.ca>
  * @license MIT
@@ -9,6 +14,8 @@
 
 const logger = require('./utils').logger;
 const node = require('./node');
+const classifier = require('./classifier');
+const S = require('./state');
 const C = require('./constants');
 
 /**
@@ -17,119 +24,176 @@ const C = require('./constants');
 const log = logger('tokenizer');
 
 /**
- * Precompiled Regex selectors for function tokens
+ * Line classification flags for function and definition tokens
  */
-const REGEX = {
-  // C type function declaration
-  c_fn_decl: /[aA0-zZ9_\s]+\(.*\)/,
-  c_struct_decl: /struct[\s]+/,
-  c_enum_decl: /enum[\s]+/,
-};
+const FN = classifier.FN;
+const DECL = classifier.STRUCT | classifier.ENUM;
+const BLOCK_OPEN = classifier.BLOCK_OPEN;
+const BLOCK_CLOSE = classifier.BLOCK_CLOSE;
+const LINE_COMM = classifier.LINE_COMM;
+const SEMI = classifier.SEMI;
 
 /**
- * Analyzes current line for tokens.
- * State is then setup dependent on scope and depth.
+ * Extra input bit set while at the root scope depth.
+ */
+const DEPTH0 = 128;
+
+/**
+ * Input width: classifier flags plus DEPTH0.
+ */
+const INPUT_BITS = 8;
+
+/**
+ * Scopes the tokenizer transitions on.
+ */
+const SCOPES = S.IN_COMM | S.IN_CODE | S.IN_DEF;
+
+/**
+ * Transition encoding:
+ *   bits  0-4   next scope bitmask
+ *   bits  5-9   closing bitmask
+ *   bits 10-14  slots opened on the current line
+ *   bit  15     block start
+ *   bit  16     partial definition turns out to be code
+ */
+const CLOSING_SHIFT = 5;
+const OPENING_SHIFT = 10;
+const T_BLOCK = 1 << 15;
+const T_DEF_TO_CODE = 1 << 16;
+const MASK = 0x1f;
+
+/**
+ * Decides the transition for a scope bitmask and line input.
  *
- * @param {object} ast tree
- * @param {object} state Parser State
- * @return {null|SKIP}
+ * @param {number} inside open scopes
+ * @param {number} input classifier flags and DEPTH0
+ * @return {number} encoded transition
  */
-function tokenizer(ast, state) {
-  const inside = 0 ||
-    state.inside[C.CODE] ||
-    state.inside[C.COMM];
+function decide(inside, input) {
+  let next = inside;
+  let closing = 0;
+  let opening = 0;
+  let flags = 0;
 
-  if (!inside && state.ln.indexOf('/*') == 0) {
-    state.current[C.COMM] = state.lno;
+  const in_comm = inside & S.IN_COMM;
+  const in_code = inside & S.IN_CODE;
+  const in_def = inside & S.IN_DEF;
 
-    if (state.ln.indexOf('*/') >= 0) {
-      state.closing[C.COMM] = true;
+  if (!in_code && !in_comm && (input & BLOCK_OPEN)) {
+    opening |= S.IN_COMM;
+
+    if (input & BLOCK_CLOSE) {
+      closing |= S.IN_COMM;
     } else {
-      state.inside[C.COMM] = true;
-      state.block_start = true;
+      next |= S.IN_COMM;
+      flags |= T_BLOCK;
     }
   }
 
-  else if (!state.inside[C.CODE] && state.ln.indexOf('//') == 0) {
-    state.current[C.COMM] = state.lno;
-    state.closing[C.COMM] = true;
-    state.block_start = true;
+  else if (!in_code && (input & LINE_COMM)) {
+    opening |= S.IN_COMM;
+    closing |= S.IN_COMM;
+    flags |= T_BLOCK;
   }
 
-  else if (state.inside[C.COMM] && state.ln.indexOf('*/') >= 0) {
-    delete state.inside[C.COMM];
-    state.closing[C.COMM] = true;
+  else if (in_comm && (input & BLOCK_CLOSE)) {
+    next &= ~S.IN_COMM;
+    closing |= S.IN_COMM;
   }
 
-  else if (!state.inside[C.COMM]) {
-    return tokenize_code(ast, state);
-  }
-}
+  else if (!in_comm) {
+    // Tokenize code and definition structures
+    const match_func = input & FN;
+    const match_decl = input & DECL;
 
-/**
- *  Tokenize code and definition structures
- * @param {AST} ast
- * @param {State} state
- */
-function tokenize_code(ast, state) {
-  const in_def = state.inside[C.DEF];
-  const in_code = state.inside[C.CODE];
+    if (!in_def && !in_code && !match_func && match_decl) {
+      opening |= S.IN_DEF;
+      next |= S.IN_DEF;
+      flags |= T_BLOCK;
+    }
 
-  const match_func = state.ln.match(REGEX.c_fn_decl);
-  const match_struct = state.ln.match(REGEX.c_struct_decl);
-  const match_enum = state.ln.match(REGEX.c_enum_decl);
+    else if (!in_def && !in_code && match_func) {
+      opening |= S.IN_CODE;
 
-  if (!in_def && !in_code && !match_func && (match_struct || match_enum)) {
-    state.current[C.DEF] = state.lno;
-    state.inside[C.DEF] = true;
-    state.block_start = true;
+      // Handle one line declarations
+      if ((input & DEPTH0) && (input & SEMI)) {
+        closing |= S.IN_CODE;
+      } else {
+        next |= S.IN_CODE;
+        flags |= T_BLOCK;
+      }
+    }
+
+    // Transform partial C.DEF into C.CODE node if partial function signature match
+    else if (in_def && (input & DEPTH0) && match_func) {
+      next = (next | S.IN_CODE) & ~S.IN_DEF;
+      flags |= T_DEF_TO_CODE;
+    }
   }
 
-  else if (!in_def && !in_code && match_func) {
-    state.current[C.CODE] = state.lno;
+  return next | (closing << CLOSING_SHIFT) |
+    (opening << OPENING_SHIFT) | flags;
+}
 
-    // Handle one line declarations
-    if (state.depth == 0 && state.ln.indexOf(';') >= 0) {
-      state.closing[C.CODE] = true;
-    } else {
-      state.inside[C.CODE] = true;
-      state.block_start = true;
+/**
+ * Precomputed transitions, indexed by scope bitmask and line input.
+ */
+const TRANSITIONS = (() => {
+  const table = new Int32Array((SCOPES + 1) << INPUT_BITS);
+  for (let inside = 0; inside <= SCOPES; inside++) {
+    for (let input = 0; input < (1 << INPUT_BITS); input++) {
+      table[(inside << INPUT_BITS) | input] = decide(inside & SCOPES, input);
     }
   }
+  return table;
+})();
 
-  else if (in_def) {
-    if (state.depth == 0) {
-      // if (state.ln.indexOf('{') == 0) {
-        // node.index(ast, state, C.DEF, { node_id: state.lno });
-      // }
+/**
+ * Analyzes current line for tokens.
+ * State is then setup dependent on scope and depth.
+ *
+ * @param {object} ast tree
+ * @param {object} state Parser State
+ * @return {null|SKIP}
+ */
+function tokenizer(ast, state) {
+  const input = state.scan.kind | (state.depth == 0 ? DEPTH0 : 0);
+  const t = TRANSITIONS[((state.inside & SCOPES) << INPUT_BITS) | input];
 
-      // else if (state.ln.indexOf('}') >= 0) {
-        // node.index(ast, state, C.DEF, { node_id: state.lno });
-      // }
+  const opening = (t >> OPENING_SHIFT) & MASK;
+  if (opening) {
+    // A line opens at most a single slot
+    state.current[31 - Math.clz32(opening)] = state.lno;
+  }
 
-      // Transform partial DEF into CODE node if partial function signature match
-      if (match_func) {
-        node.transform(ast, state.current[C.DEF], C.DEF, C.CODE);
+  if (t & T_DEF_TO_CODE) {
+    def_to_code(ast, state);
+  }
 
-        state.current[C.CODE] = state.current[C.DEF];
-        state.previous[C.CODE] = state.previous[C.DEF];
-        state.inside[C.CODE] = true;
+  state.inside = (state.inside & ~SCOPES) | (t & MASK);
+  state.closing |= (t >> CLOSING_SHIFT) & MASK;
 
-        delete state.previous[C.DEF];
-        delete state.current[C.DEF];
-        delete state.inside[C.DEF];
-      }
-    }
+  if (t & T_BLOCK) {
+    state.block_start = true;
   }
+}
 
-  else if (in_code) {
-    
-  }
+/**
+ * Converts the partial definition being tracked into a code node,
+ * moving its slots across.
+ *
+ * @param {AST} ast
+ * @param {State} state
+ */
+function def_to_code(ast, state) {
+  node.transform(ast, state, state.current[S.DEF], C.DEF, C.CODE);
 
-  else {
-    // node.index(ast, state, C.CHAR, { node_id: state.lno });
-  }
+  state.current[S.CODE] = state.current[S.DEF];
+  state.previous[S.CODE] = state.previous[S.DEF];
+
+  state.previous[S.DEF] = S.NONE;
+  state.current[S.DEF] = S.NONE;
 }
 
 /* Expose tokenizer interface */
-module.exports = tokenizer;
\ No newline at end of file
+module.exports = tokenizer;
@@ -0,0 +1,79 @@
+/**
+ * @fileOverview
+ * Interned type name dictionary.
+ *
+ * Member declarations refer to their type by an integer id into this
+ * table, so each distinct type name is held once however many members
+ * use it. A table may be shared between the ASTs of a project by passing
+ * it as the `types` generation option.
+ *
+ * @name types.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+/**
+ * Id returned for names not in the table.
+ */
+const UNKNOWN = -1;
+
+class TypeTable {
+  constructor() {
+    this.ids = new Map();
+    this.names = [];
+  }
+
+  /**
+   * Number of interned names.
+   * @return {number}
+   */
+  get size() {
+    return this.names.length;
+  }
+
+  /**
+   * Interns a type name.
+   *
+   * @param {string} name normalized type name
+   * @return {number} id of the name
+   */
+  intern(name) {
+    let id = this.ids.get(name);
+    if (id === undefined) {
+      id = this.names.length;
+      this.ids.set(name, id);
+      this.names.push(name);
+    }
+    return id;
+  }
+
+  /**
+   * Id of a type name, without interning it.
+   *
+   * @param {string} name
+   * @return {number} id, UNKNOWN when absent
+   */
+  lookup(name) {
+    const id = this.ids.get(name);
+    return id === undefined ? UNKNOWN : id;
+  }
+
+  /**
+   * Type name of an id.
+   *
+   * @param {number} id
+   * @return {string|undefined}
+   */
+  name(id) {
+    return this.names[id];
+  }
+
+  toJSON() {
+    return this.names;
+  }
+}
+
+module.exports = {
+  UNKNOWN,
+  TypeTable,
+};
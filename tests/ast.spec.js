@@ -344,4 +344,17 @@ describe('Macros', async () => {
     expect(ast.count(CODE)).to.deep.equal({ [CODE]: 3 })
     expect(ast.count(CHAR)).to.deep.equal({ [CHAR]: 1 })
   })
-});
\ No newline at end of file
+});
+describe('Lookbehind', async () => {
+  let ast;
+
+  before(async () => {
+    ast = await ast_gen(setup('// line\n// line\n}\nint g(void) {\n};').input);
+  })
+
+  it('should not merge code into a node detached from its comment', async () => {
+    expect(ast.keys(CODE)).to.deep.equal(['2', '3'])
+    expect(Object.keys(ast.node(2).data)).to.deep.equal(['2'])
+    expect(Object.keys(ast.node(3).data)).to.deep.equal(['3', '4'])
+  })
+});
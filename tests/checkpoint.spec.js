@@ -0,0 +1,105 @@
+/**
+ * @fileOverview
+ * Tests for parser checkpoints and range parsing
+ *
+ * @name checkpoint.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const checkpoint = require('../lib/checkpoint');
+const ast_from_file = require('../lib/abstractor').ast_from_file;
+const C = require('../lib/constants');
+
+/**
+ * Copies of the samples making up the parsed file.
+ */
+const COPIES = 20;
+
+/**
+ * Nodes of a full parse starting within a range.
+ */
+function within(ast, start, end) {
+  const ids = {};
+  for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR]) {
+    ids[type] = ast.keys(type).filter((id) => id >= start && id <= end);
+  }
+  return ids;
+}
+
+// ////////////////////////////////////////////////////////////////////
+describe('Checkpoints', async () => {
+  let dir;
+  let file;
+  let full;
+
+  before(async () => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'c-ast-checkpoint-'));
+    file = path.join(dir, 'sample.h');
+    fs.writeFileSync(file, (samples.EXAMPLE_1 + samples.STRUCT_FUNCS +
+      samples.ENUMS + samples.FUNC_SEQUENCE).repeat(COPIES));
+    full = await ast_from_file(file);
+  });
+
+  after(async () => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('should build the same AST while recording checkpoints', async () => {
+    const ast = checkpoint.build(file, { checkpoints: 64 });
+    const sidecar = checkpoint.load(file);
+
+    expect(ast.json()).to.equal(full.json());
+    expect(sidecar.points.length).to.be.above(COPIES / 2);
+    expect(sidecar.points[0].lno).to.be.above(63);
+  });
+
+  it('should parse ranges exactly as a full parse', async () => {
+    const lines = full.source.length;
+
+    for (const start of [0, lines >> 2, lines >> 1, lines - 20]) {
+      const end = start + 10;
+      const ast = checkpoint.range(file, start, end);
+
+      for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR]) {
+        for (const id of ast.keys(type)) {
+          expect(JSON.stringify(ast[type][id]))
+            .to.equal(JSON.stringify(full[type][id]));
+        }
+      }
+
+      expect(within(ast, start, end)).to.deep.equal(within(full, start, end));
+    }
+  });
+
+  it('should only parse around the range', async () => {
+    const lines = full.source.length;
+    const ast = checkpoint.range(file, lines >> 1, (lines >> 1) + 5);
+
+    expect(ast.range.start).to.be.above(0);
+    expect(ast.range.end - ast.range.start).to.be.below(lines / 4);
+    expect(ast.source[0]).to.be.undefined;
+  });
+
+  it('should ignore outdated checkpoints', async () => {
+    fs.appendFileSync(file, '\nint appended(void);\n');
+    expect(checkpoint.load(file)).to.equal(null);
+
+    const ast = checkpoint.range(file, 10, 12);
+    expect(ast.range.start).to.equal(0);
+  });
+
+  it('should reject invalid ranges', async () => {
+    expect(checkpoint.bounds('9000,9050')).to.deep.equal([9000, 9050]);
+    expect(checkpoint.bounds(12)).to.deep.equal([12, 12]);
+    expect(() => checkpoint.bounds('5,1')).to.throw();
+  });
+});
@@ -0,0 +1,84 @@
+/**
+ * @fileOverview
+ * Tests for the linear line classifier
+ *
+ * @name classifier.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const classifier = require('../lib/classifier');
+const classify = classifier.classify;
+const FN = classifier.FN;
+const STRUCT = classifier.STRUCT;
+const ENUM = classifier.ENUM;
+
+/**
+ * Legacy regex selectors the classifier must agree with.
+ */
+const LEGACY = {
+  c_fn_decl: /[aA0-zZ9_\s]+\(.*\)/,
+  c_struct_decl: /struct[\s]+/,
+  c_enum_decl: /enum[\s]+/,
+};
+
+function legacy(ln) {
+  return (LEGACY.c_fn_decl.test(ln) ? FN : 0) |
+    (LEGACY.c_struct_decl.test(ln) ? STRUCT : 0) |
+    (LEGACY.c_enum_decl.test(ln) ? ENUM : 0);
+}
+
+// ////////////////////////////////////////////////////////////////////
+describe('Classifier', async () => {
+  it('should recognize function declarations', async () => {
+    expect(classify('int main()')).to.equal(FN);
+    expect(classify('nk_vec2(float x, float y)')).to.equal(FN);
+    expect(classify('NK_API void nk_free(struct nk_context*);'))
+      .to.equal(FN | STRUCT);
+  });
+
+  it('should recognize struct and enum declarations', async () => {
+    expect(classify('typedef struct prime_input {')).to.equal(STRUCT);
+    expect(classify('enum nk_heading {NK_UP, NK_RIGHT};')).to.equal(ENUM);
+    expect(classify('struct;')).to.equal(0);
+  });
+
+  it('should ignore unbalanced and detached parenthesis', async () => {
+    expect(classify('foo(')).to.equal(0);
+    expect(classify(') foo(')).to.equal(0);
+    expect(classify('(void)')).to.equal(0);
+    expect(classify('x\n(y)')).to.equal(FN);
+    expect(classify('x(\n)')).to.equal(0);
+  });
+
+  it('should agree with the legacy regex selectors', async () => {
+    const alphabet = ['a', 'Z', '9', '_', ' ', '\t', '\n', '(', ')', ';',
+      '{', '*', '#', ' ', ' ', 'struct', 'enum', 'struct ',
+      'enum\t', ',', '/'];
+
+    let seed = 7;
+    const rand = (n) => {
+      seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+      return seed % n;
+    };
+
+    for (let i = 0; i < 5000; i++) {
+      let ln = '';
+      const len = rand(12);
+      for (let k = 0; k < len; k++) {
+        ln += alphabet[rand(alphabet.length)];
+      }
+      expect(classify(ln)).to.equal(legacy(ln));
+    }
+  });
+
+  it('should classify pathological lines in linear time', async () => {
+    const run = 'a'.repeat(1024 * 1024);
+    expect(classify(run)).to.equal(0);
+    expect(classify(run + '(' + run)).to.equal(0);
+    expect(classify(run + '(' + run + ')')).to.equal(FN);
+  });
+});
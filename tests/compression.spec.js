@@ -0,0 +1,126 @@
+/**
+ * @fileOverview
+ * Tests for compressed input and output files
+ *
+ * @name compression.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const zlib = require('zlib');
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_from_file = require('../lib/abstractor').ast_from_file;
+const compression = require('../lib/compression');
+const checkpoint = require('../lib/checkpoint');
+const lines = require('../lib/lines');
+const symbols = require('../lib/symbols');
+
+// ////////////////////////////////////////////////////////////////////
+describe('Compression', async () => {
+  const TEXT = samples.STRUCT_FUNCS + samples.EXAMPLE_1;
+  let dir;
+  let expected;
+
+  before(async () => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'c-ast-compression-'));
+    fs.writeFileSync(path.join(dir, 'plain.h'), TEXT);
+    fs.writeFileSync(path.join(dir, 'gzip.h.gz'), zlib.gzipSync(TEXT));
+    fs.writeFileSync(path.join(dir, 'brotli.c.br'),
+      zlib.brotliCompressSync(TEXT));
+    // Gzip is recognized by its magic bytes, whatever the name
+    fs.writeFileSync(path.join(dir, 'misnamed.h'), zlib.gzipSync(TEXT));
+
+    expected = (await ast_from_file(path.join(dir, 'plain.h'))).json();
+  });
+
+  after(async () => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('should detect compressed input', async () => {
+    expect(compression.detect(path.join(dir, 'plain.h'))).to.equal(null);
+    expect(compression.detect(path.join(dir, 'gzip.h.gz')))
+      .to.equal(compression.GZIP);
+    expect(compression.detect(path.join(dir, 'misnamed.h')))
+      .to.equal(compression.GZIP);
+    expect(compression.detect(path.join(dir, 'brotli.c.br')))
+      .to.equal(compression.BROTLI);
+  });
+
+  it('should parse compressed input as the plain file', async () => {
+    for (const name of ['gzip.h.gz', 'brotli.c.br', 'misnamed.h']) {
+      const ast = await ast_from_file(path.join(dir, name));
+      expect(ast.json()).to.equal(expected);
+    }
+  });
+
+  it('should fail on truncated input', async () => {
+    const file = path.join(dir, 'truncated.h.gz');
+    const data = zlib.gzipSync(samples.EXAMPLE_1.repeat(50));
+    fs.writeFileSync(file, data.subarray(0, data.length >> 1));
+
+    let failed = null;
+    try {
+      await ast_from_file(file);
+    } catch (err) {
+      failed = err;
+    } finally {
+      fs.unlinkSync(file);
+    }
+    expect(failed).to.not.equal(null);
+  });
+
+  it('should split compressed lines at decompressed offsets', async () => {
+    const plain = [];
+    const gzip = [];
+    lines.each(path.join(dir, 'plain.h'), 0, (t, o) => plain.push([t, o]));
+    lines.each(path.join(dir, 'gzip.h.gz'), 0, (t, o) => gzip.push([t, o]));
+    expect(gzip).to.deep.equal(plain);
+
+    const [text, offset] = plain[plain.length >> 1];
+    const resumed = [];
+    lines.each(path.join(dir, 'gzip.h.gz'), offset, (t) => {
+      resumed.push(t);
+      return false;
+    });
+    expect(resumed).to.deep.equal([text]);
+
+    const range = checkpoint.range(path.join(dir, 'gzip.h.gz'), 40, 45);
+    expect(range.json())
+      .to.equal(checkpoint.range(path.join(dir, 'plain.h'), 40, 45).json());
+  });
+
+  it('should compress output by extension', async () => {
+    for (const name of ['out.json', 'out.json.gz', 'out.json.br']) {
+      const file = path.join(dir, name);
+      const out = compression.writer(file);
+      out.stream.end(expected);
+      await out.done;
+
+      const data = fs.readFileSync(file);
+      const text = name.endsWith('.gz') ? zlib.gunzipSync(data) :
+        name.endsWith('.br') ? zlib.brotliDecompressSync(data) : data;
+      expect(text.toString()).to.equal(expected);
+      if (name != 'out.json') {
+        expect(data.length).to.be.below(expected.length / 4);
+      }
+    }
+  });
+
+  it('should index compressed sources', async () => {
+    const db = path.join(dir, 'symbols.json');
+    const stats = await symbols.build(dir, { db });
+    expect(stats.files).to.equal(4);
+
+    const found = symbols.lookup('nk_window_get_size', { dir, db });
+    expect(found.map((sym) => path.basename(sym.file)).sort())
+      .to.deep.equal(['brotli.c.br', 'gzip.h.gz', 'misnamed.h', 'plain.h']);
+  });
+});
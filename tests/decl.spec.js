@@ -0,0 +1,129 @@
+/**
+ * @fileOverview
+ * Tests for member declaration decomposition
+ *
+ * @name decl.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const SnapshotStore = require('../lib/snapshot').SnapshotStore;
+const TypeTable = require('../lib/types').TypeTable;
+const decl = require('../lib/decl');
+const C = require('../lib/constants');
+
+const helpers = require('./test_helper');
+const setup = helpers.setup;
+
+// ////////////////////////////////////////////////////////////////////
+describe('Member Declarations', async () => {
+  let ast;
+
+  before(async () => {
+    ast = await ast_gen(setup(samples.STRUCT_MEMBERS).input, { decl: true });
+  });
+
+  const member = (lno) => ast.node(lno).decl;
+  const type = (lno) => ast.types.name(member(lno).type);
+
+  it('should decompose qualifiers, pointers and names', async () => {
+    expect(member(1).name).to.equal('name');
+    expect(type(1)).to.equal('char');
+    expect(member(1).ptr).to.equal(1);
+    expect(decl.qualifiers(member(1).quals)).to.deep.equal(['const']);
+  });
+
+  it('should decompose array dimensions and bitfields', async () => {
+    expect(member(2).dims).to.deep.equal(['4', 'NK_MAX']);
+    expect(type(2)).to.equal('struct nk_vec2');
+    expect(member(3).bits).to.equal(3);
+    expect(type(3)).to.equal('unsigned int');
+  });
+
+  it('should list comma separated declarators', async () => {
+    expect(member(4).names).to.deep.equal(['x', 'y']);
+    expect(type(4)).to.equal('float');
+  });
+
+  it('should leave declarators with parts of their own undecomposed',
+    async () => {
+      const types = new TypeTable();
+      for (const line of ['int *a, b;', 'int a, *b;', 'int a[3], b;',
+        'int a : 3, b;']) {
+        expect(decl.parse(line, types)).to.be.undefined;
+      }
+      expect(decl.parse('int a, b;', types).names).to.deep.equal(['a', 'b']);
+    });
+
+  it('should leave qualified pointers undecomposed', async () => {
+    const types = new TypeTable();
+    expect(decl.parse('char *const p;', types)).to.be.undefined;
+    expect(decl.parse('const char *volatile *p;', types)).to.be.undefined;
+
+    const p = decl.parse('const char *p;', types);
+    expect(p.ptr).to.equal(1);
+    expect(decl.qualifiers(p.quals)).to.deep.equal(['const']);
+  });
+
+  it('should leave members undecomposed by default', async () => {
+    const plain = await ast_gen(setup(samples.STRUCT_MEMBERS).input);
+    expect(plain.node(1).decl).to.be.undefined;
+    expect(plain.types).to.equal(null);
+    expect(JSON.parse(plain.json()).types).to.be.undefined;
+  });
+
+  it('should decompose long member lines in linear time', async () => {
+    const types = new TypeTable();
+    const space = ' '.repeat(100000);
+    const start = Date.now();
+
+    expect(decl.parse(`int${space}x;`, types).name).to.equal('x');
+    expect(decl.parse(`int x${space}: 3;`, types).bits).to.equal(3);
+    expect(decl.parse(`int x :${space}3;`, types).bits).to.equal(3);
+    expect(decl.parse(`int x[1]${space}y;`, types).name).to.equal('y');
+    expect(decl.parse(`void (*${space}f)(int);`, types).name).to.equal('f');
+    expect(decl.parse(`A = 1${space}x`, types, true).value)
+      .to.equal(`1${space}x`);
+    expect(Date.now() - start).to.be.below(1000);
+  });
+
+  it('should decompose function pointers', async () => {
+    expect(member(5).name).to.equal('draw');
+    expect(type(5)).to.equal(
+      'void (*)(struct nk_command_buffer *, nk_handle)');
+  });
+
+  it('should intern each type name once', async () => {
+    expect(member(6).type).to.equal(member(2).type);
+    expect(ast.types.size).to.equal(5);
+    expect(JSON.parse(ast.json()).types).to.deep.equal(ast.types.names);
+  });
+
+  it('should decompose enum members into names and values', async () => {
+    expect(member(9).name).to.equal('NK_STYLE_NONE');
+    expect(member(9).value).to.be.undefined;
+    expect(member(10).value).to.equal('(1 << 2)');
+    expect(member(10).type).to.be.undefined;
+  });
+
+  it('should share a type table between ASTs', async () => {
+    const types = new TypeTable();
+    const a = await ast_gen(setup(samples.STRUCT_MEMBERS).input, { types });
+    const b = await ast_gen(setup(samples.STRUCT).input, { types });
+
+    expect(a.types).to.equal(types);
+    expect(b.node(7).decl.type).to.equal(types.lookup('float'));
+    expect(types.size).to.equal(5);
+  });
+
+  it('should publish types along with snapshots', async () => {
+    const store = new SnapshotStore();
+    expect(store.publish(ast).json()).to.equal(ast.json());
+    expect(ast.keys(C.DEF)).to.deep.equal(['0', '8']);
+  });
+});
@@ -0,0 +1,90 @@
+/**
+ * @fileOverview
+ * Tests for cross-file string interning
+ *
+ * @name intern.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_from_text = require('../lib/abstractor').ast_from_text;
+const InternPool = require('../lib/intern').InternPool;
+const NodePool = require('../lib/pool').NodePool;
+const C = require('../lib/constants');
+
+// ////////////////////////////////////////////////////////////////////
+describe('Intern Pool', async () => {
+  it('should generate the same trees', async () => {
+    const pool = new InternPool();
+
+    for (const name in samples) {
+      const plain = await ast_from_text(samples[name]);
+      const interned = await ast_from_text(samples[name], { intern: pool });
+      expect(interned.json()).to.equal(plain.json());
+    }
+  });
+
+  it('should hold each distinct line once across asts', async () => {
+    const pool = new InternPool();
+    const text = samples.STRUCT_FUNCS + samples.EXAMPLE_1;
+    const a = await ast_from_text(text, { intern: pool });
+    const b = await ast_from_text(text + samples.FUNC, { intern: pool });
+
+    expect(pool.size).to.be.below(a.source.length + b.source.length);
+    expect(pool.count(a.source[0])).to.be.above(1);
+    expect(pool.stats().hits).to.be.above(a.source.length);
+  });
+
+  it('should share member identifiers', async () => {
+    const pool = new InternPool();
+    const ast = await ast_from_text(samples.STRUCT_MEMBERS,
+      { intern: pool, decl: true });
+
+    let members = 0;
+    for (const id of ast.keys(C.DEF)) {
+      for (const member of ast.inner(id, C.MEMB)) {
+        if (member.decl) {
+          expect(pool.count(member.decl.name)).to.be.above(0);
+          members++;
+        }
+      }
+    }
+    expect(members).to.be.above(0);
+  });
+
+  it('should pool strings UTF-8 cannot carry as they are', async () => {
+    const lease = new InternPool().lease();
+    for (const str of ['naïve ✓ 😀', 'lone \ud800 surrogate', '\udc00']) {
+      expect(lease.intern(str + '')).to.equal(str);
+    }
+  });
+
+  it('should drop strings with their last reference', async () => {
+    const pool = new InternPool();
+    const shared = samples.STRUCT_FUNCS;
+    const a = await ast_from_text(shared + samples.ENUMS, { intern: pool });
+    const b = await ast_from_text(shared + samples.MACROS, { intern: pool });
+    const line = a.source[1];
+    const count = pool.count(line);
+    const held = a.source.filter((s) => s === line).length;
+
+    pool.release(a);
+    expect(a.strings).to.equal(null);
+    expect(held).to.be.above(0);
+    expect(pool.count(line)).to.equal(count - held);
+    expect(a.json()).to.equal((await ast_from_text(shared + samples.ENUMS))
+      .json());
+
+    // Releasing twice has no effect
+    pool.release(a);
+    expect(pool.count(line)).to.equal(count - held);
+
+    new NodePool().release(b);
+    expect(pool.size).to.equal(0);
+    expect(pool.count(line)).to.equal(0);
+  });
+});
@@ -0,0 +1,74 @@
+/**
+ * @fileOverview
+ * Tests for AST memory accounting
+ *
+ * @name memory.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const C = require('../lib/constants');
+
+const helpers = require('./test_helper');
+const setup = helpers.setup;
+
+// ////////////////////////////////////////////////////////////////////
+describe('Memory Stats', async () => {
+  let ast;
+
+  before(async () => {
+    ast = await ast_gen(setup(samples.ENUMS_SINGLE_LINE).input,
+      { memory: true });
+  });
+
+  it('should count every container', async () => {
+    const report = ast.memoryStats();
+    const containers = report.containers;
+
+    for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR]) {
+      expect(containers[type].count).to.equal(ast.keys(type).length);
+    }
+    expect(containers[C.MEMB].count).to.equal(ast.inner(9, C.MEMB).length);
+    expect(containers.index.count).to.equal(Object.keys(ast.index).length);
+    expect(containers.source.count).to.equal(ast.source.length);
+  });
+
+  it('should total the estimated bytes', async () => {
+    const report = ast.memoryStats();
+    let total = 0;
+    for (const name in report.containers) {
+      expect(report.containers[name].bytes).to.be.above(0);
+      total += report.containers[name].bytes;
+    }
+    expect(report.total).to.equal(total);
+  });
+
+  it('should sample peak usage during the parse', async () => {
+    const peak = ast.memoryStats().peak;
+    expect(peak.rss).to.be.above(0);
+    expect(peak.heap).to.be.above(0);
+  });
+
+  it('should only sample when asked to', async () => {
+    const plain = await ast_gen(setup(samples.ENUMS_SINGLE_LINE).input);
+    const report = plain.memoryStats();
+
+    expect(report.peak).to.equal(null);
+    expect(report.total).to.equal(ast.memoryStats().total);
+  });
+
+  it('should not account for skipped work', async () => {
+    const slim = await ast_gen(setup(samples.ENUMS_SINGLE_LINE).input,
+      { index: false, members: false });
+    const report = slim.memoryStats();
+
+    expect(report.containers.index.bytes).to.equal(0);
+    expect(report.containers[C.MEMB].count).to.equal(0);
+    expect(report.total).to.be.below(ast.memoryStats().total);
+  });
+});
@@ -0,0 +1,77 @@
+/**
+ * @fileOverview
+ * Tests for the fixed shape Node and its recycling pool
+ *
+ * @name pool.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const Node = require('../lib/node').Node;
+const NodePool = require('../lib/pool').NodePool;
+const C = require('../lib/constants');
+
+const helpers = require('./test_helper');
+const setup = helpers.setup;
+
+// ////////////////////////////////////////////////////////////////////
+describe('Node Shape', async () => {
+  let ast;
+
+  before(async () => {
+    ast = await ast_gen(setup(samples.ENUMS_SINGLE_LINE).input);
+  });
+
+  it('should build every node from the Node class', async () => {
+    for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR]) {
+      for (const id of ast.keys(type)) {
+        expect(ast[type][id]).to.be.instanceof(Node);
+      }
+    }
+    expect(ast.node(14).inner[0]).to.be.instanceof(Node);
+  });
+
+  it('should share one field layout across node kinds', async () => {
+    const def = Object.keys(ast.node(9));
+    const memb = Object.keys(ast.node(14));
+    expect(def).to.deep.equal(memb);
+  });
+
+  it('should expose integer type tags', async () => {
+    expect(ast.node(9).tag).to.equal(C.TAG[C.DEF]);
+    expect(ast.node(14).tag).to.equal(C.TAG[C.MEMB]);
+  });
+});
+
+// ////////////////////////////////////////////////////////////////////
+describe('Node Pool', async () => {
+  it('should recycle released nodes into the next parse', async () => {
+    const pool = new NodePool();
+
+    const first = await ast_gen(setup(samples.STRUCT_FUNCS).input, { pool });
+    const expected = first.json();
+    const created = pool.stats().created;
+
+    pool.release(first);
+    expect(first.keys(C.COMM).length).to.equal(0);
+
+    const second = await ast_gen(setup(samples.STRUCT_FUNCS).input, { pool });
+    expect(second.json()).to.equal(expected);
+    // Only nodes merged away by combine() are allocated again.
+    expect(pool.stats().created - created).to.be.below(created / 2);
+    expect(pool.stats().reused).to.be.above(0);
+  });
+
+  it('should respect its idle limit', async () => {
+    const pool = new NodePool(2);
+    const ast = await ast_gen(setup(samples.STRUCT_DECLS).input, { pool });
+
+    pool.release(ast);
+    expect(pool.stats().idle).to.equal(2);
+  });
+});
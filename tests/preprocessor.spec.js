@@ -0,0 +1,112 @@
+/**
+ * @fileOverview
+ * Tests for the preprocessor front stage
+ *
+ * @name preprocessor.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const C = require('../lib/constants');
+
+const helpers = require('./test_helper');
+const setup = helpers.setup;
+
+// ////////////////////////////////////////////////////////////////////
+describe('Preprocessor', async () => {
+
+  it('should leave the default parse untouched', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input);
+    const nodes = JSON.parse(ast.json()).nodes;
+
+    expect(Object.keys(nodes)).to.deep.equal(
+      [C.COMM, C.CODE, C.DEF, C.CHAR]);
+    expect(ast.keys(C.SKIP)).to.be.empty;
+  });
+
+  it('should skip #if 0 regions as a single span', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input,
+      { preprocess: true });
+
+    expect(ast.keys(C.SKIP)).to.deep.equal(['2']);
+    expect(ast.node(2).data).to.deep.equal({ 2: '#if 0', 5: '#endif' });
+    expect(JSON.parse(ast.json()).nodes).to.have.property(C.SKIP);
+  });
+
+  it('should index every line of a disabled region', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input,
+      { preprocess: true });
+
+    for (let lno = 2; lno <= 5; lno++) {
+      expect(ast.index[lno].node_id).to.equal(2);
+      expect(ast.index[lno].type).to.equal(C.SKIP);
+    }
+
+    // A middle line resolves to the span holding it
+    const entry = ast.index[4];
+    expect(ast.source[4].trim()).to.equal('return 0;');
+    expect(ast.node(entry.node_id)).to.equal(ast.node(2));
+    expect(ast.index[6]).to.not.equal(undefined);
+    expect(ast.index[6].type).to.not.equal(C.SKIP);
+  });
+
+  it('should parse every branch of undecided conditions', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input,
+      { preprocess: true });
+
+    expect(ast.keys(C.CODE)).to.deep.equal(['9', '12', '17']);
+  });
+
+  it('should skip branches of undefined macros', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input,
+      { undefines: ['NK_IMPLEMENTATION'] });
+
+    expect(ast.keys(C.SKIP)).to.deep.equal(['2', '8']);
+    expect(ast.node(8).data).to.deep.equal(
+      { 8: '#ifdef NK_IMPLEMENTATION', 11: '#else' });
+    expect(ast.keys(C.CODE)).to.deep.equal(['12', '17']);
+    expect(ast.node(17).assocs[C.COMM]).to.deep.equal([16]);
+  });
+
+  it('should skip the else branch of defined macros', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input,
+      { defines: 'NK_IMPLEMENTATION' });
+
+    expect(ast.keys(C.SKIP)).to.deep.equal(['2', '11']);
+    expect(ast.keys(C.CODE)).to.deep.equal(['9', '17']);
+    expect(ast.node(9).data).to.not.have.property('8');
+  });
+
+  it('should fold continued directives into a single node', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input,
+      { preprocess: true });
+
+    expect(Object.keys(ast.node(14).data)).to.deep.equal(['14', '15']);
+    expect(ast.node(14).type).to.equal(C.CHAR);
+    expect(ast.index[15].node_id).to.equal(14);
+  });
+
+  it('should close regions left open at the end of input', async () => {
+    const ast = await ast_gen(setup(samples.MACROS).input,
+      { undefines: 'NK_INCLUDE_VERTEX_BUFFER_OUTPUT' });
+
+    const span = ast.node(13);
+    const last = ast.source.length - 1;
+    expect(span.type).to.equal(C.SKIP);
+    expect(Object.keys(span.data)).to.deep.equal(['13', String(last)]);
+    expect(ast.keys(C.CODE)).to.deep.equal(['6']);
+  });
+
+  it('should honor extraction profiles', async () => {
+    const ast = await ast_gen(setup(samples.CONDITIONALS).input,
+      { undefines: 'NK_IMPLEMENTATION', only: 'code' });
+
+    expect(ast.keys(C.SKIP)).to.be.empty;
+    expect(ast.keys(C.CODE)).to.deep.equal(['12', '17']);
+  });
+});
@@ -0,0 +1,105 @@
+/**
+ * @fileOverview
+ * Tests for extraction profiles
+ *
+ * @name profile.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const C = require('../lib/constants');
+
+const helpers = require('./test_helper');
+const setup = helpers.setup;
+
+/**
+ * Drops associations to kinds outside of the profile.
+ */
+function scrub(node, kinds) {
+  const assocs = {};
+  for (const k in node.assocs) {
+    if (kinds.indexOf(k) >= 0) {
+      assocs[k] = node.assocs[k];
+    }
+  }
+  return assocs;
+}
+
+// ////////////////////////////////////////////////////////////////////
+describe('Extraction Profiles', async () => {
+  let full;
+
+  before(async () => {
+    full = await ast_gen(setup(samples.STRUCT_FUNCS).input);
+  });
+
+  it('should only build the requested kinds', async () => {
+    const ast = await ast_gen(setup(samples.STRUCT_FUNCS).input,
+      { only: 'comments' });
+
+    expect(ast.keys(C.COMM)).to.deep.equal(full.keys(C.COMM));
+    expect(ast.keys(C.CODE)).to.be.empty;
+    expect(ast.keys(C.DEF)).to.be.empty;
+    expect(ast.keys(C.CHAR)).to.be.empty;
+
+    for (const id of ast.keys(C.COMM)) {
+      expect(ast.node(id).data).to.deep.equal(full.node(id).data);
+    }
+  });
+
+  it('should match the full parse for the requested kinds', async () => {
+    const kinds = [C.COMM, C.DEF, C.MEMB];
+    const ast = await ast_gen(setup(samples.STRUCT_FUNCS).input,
+      { only: [C.COMM, C.DEF] });
+
+    expect(ast.keys(C.CODE)).to.be.empty;
+    for (const type of [C.COMM, C.DEF]) {
+      expect(ast.keys(type)).to.deep.equal(full.keys(type));
+      for (const id of ast.keys(type)) {
+        expect(ast.node(id).assocs)
+          .to.deep.equal(scrub(full.node(id), kinds));
+      }
+    }
+  });
+
+  it('should still detect code through provisional definitions', async () => {
+    const ast = await ast_gen(setup(samples.STRUCT_FUNCS).input,
+      { only: 'code' });
+
+    expect(ast.keys(C.CODE)).to.deep.equal(full.keys(C.CODE));
+    expect(ast.node(15).data).to.deep.equal(full.node(15).data);
+  });
+
+  it('should skip the line index', async () => {
+    const ast = await ast_gen(setup(samples.ENUMS_SINGLE_LINE).input,
+      { index: false });
+
+    expect(ast.index).to.equal(null);
+    expect(ast.node(9).id).to.equal(9);
+    expect(JSON.parse(ast.json())).to.not.have.property('index');
+  });
+
+  it('should skip struct members', async () => {
+    const ast = await ast_gen(setup(samples.ENUMS_SINGLE_LINE).input,
+      { members: false });
+
+    expect(ast.keys(C.DEF)).to.deep.equal(['8', '9']);
+    expect(ast.node(9).inner).to.be.undefined;
+    expect(ast.keys(C.COMM)).to.not.include('14.1');
+  });
+
+  it('should reject unknown kinds', async () => {
+    let err;
+    try {
+      await ast_gen(setup('').input, { only: 'macros' });
+    } catch (e) {
+      err = e;
+    }
+    expect(err).to.be.instanceof(Error);
+  });
+});
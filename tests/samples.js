@@ -363,6 +363,43 @@ nk_sqrt(float x)
 `
 
 
+const STRUCT_MEMBERS =
+`struct nk_style_item {
+    const char *name; /* display name */
+    struct nk_vec2 pos[4][NK_MAX];
+    unsigned int flags : 3;
+    float x, y;
+    void (*draw)(struct nk_command_buffer*, nk_handle);
+    struct nk_vec2 size;
+};
+enum nk_style_flags {
+    NK_STYLE_NONE,
+    NK_STYLE_BORDER = (1 << 2)
+};
+`;
+
+const CONDITIONALS =
+`#ifndef NK_SAMPLE_H
+#define NK_SAMPLE_H
+#if 0
+NK_API int nk_dead(void) {
+    return 0;
+#endif
+
+/* Implementation only */
+#ifdef NK_IMPLEMENTATION
+NK_API int nk_impl(void) {
+}
+#else
+NK_API int nk_api(void);
+#endif
+#define nk_clamp(i,v,x) \\
+    (nk_max(nk_min(v,x), i))
+/* Declared after the macros */
+NK_API int nk_after(void);
+#endif
+`;
+
 
 const SAMPLES = {
   STRUCT_FUNCS,
@@ -376,6 +413,8 @@ const SAMPLES = {
   ENUMS,
   ENUMS_SINGLE_LINE,
   MACROS,
+  STRUCT_MEMBERS,
+  CONDITIONALS,
   EXAMPLE_1
 };
 
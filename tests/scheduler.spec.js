@@ -0,0 +1,85 @@
+/**
+ * @fileOverview
+ * Tests for time sliced parsing
+ *
+ * @name scheduler.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const Scheduler = require('../lib/scheduler').Scheduler;
+
+const helpers = require('./test_helper');
+const setup = helpers.setup;
+
+/**
+ * Sample repeated into an input spanning many slices.
+ */
+const LARGE = samples.STRUCT_FUNCS.repeat(400);
+
+// ////////////////////////////////////////////////////////////////////
+describe('Scheduler', async () => {
+  it('should run higher priority tasks first', async () => {
+    const runner = new Scheduler();
+    const order = [];
+    const task = (name, slices) => () => {
+      order.push(name);
+      return --slices > 0;
+    };
+
+    runner.schedule(task('low', 2), 'background');
+    runner.schedule(task('high', 2), 'interactive');
+    await new Promise((resolve) => setTimeout(resolve, 20));
+
+    expect(order).to.deep.equal(['high', 'high', 'low', 'low']);
+  });
+
+  it('should age in starved tasks', async () => {
+    const runner = new Scheduler(2);
+    const order = [];
+
+    runner.schedule(() => { order.push('low'); return false; }, 'background');
+    runner.schedule(() => { order.push('high'); return order.length < 6; },
+      'interactive');
+    await new Promise((resolve) => setTimeout(resolve, 20));
+
+    expect(order.indexOf('low')).to.equal(2);
+  });
+
+  it('should reject unknown priorities', async () => {
+    let err;
+    try {
+      await ast_gen(setup('').input, { slice: 2, priority: 'urgent' });
+    } catch (e) {
+      err = e;
+    }
+    expect(err).to.be.instanceof(Error);
+  });
+});
+
+// ////////////////////////////////////////////////////////////////////
+describe('Sliced Parsing', async () => {
+  it('should produce the same tree as a regular parse', async () => {
+    const expected = (await ast_gen(setup(LARGE).input)).json();
+    const ast = await ast_gen(setup(LARGE).input, { slice: 1 });
+
+    expect(ast.json()).to.equal(expected);
+  });
+
+  it('should yield to the event loop in between slices', async () => {
+    const runner = new Scheduler();
+    let turns = 0;
+    const timer = setInterval(() => turns++, 0);
+
+    await ast_gen(setup(LARGE).input, { slice: 0.1, scheduler: runner });
+    clearInterval(timer);
+
+    expect(runner.slices).to.be.above(1);
+    expect(turns).to.be.above(0);
+  });
+});
@@ -0,0 +1,81 @@
+/**
+ * @fileOverview
+ * Tests for the trigram comment index
+ *
+ * @name search.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_from_text = require('../lib/abstractor').ast_from_text;
+const search = require('../lib/search');
+const C = require('../lib/constants');
+
+/**
+ * Comment nodes holding a substring, by scanning every comment.
+ */
+function scan(ast, query) {
+  return ast.keys(C.COMM).filter((id) =>
+    Object.values(ast[C.COMM][id].data).some((t) => t.indexOf(query) >= 0));
+}
+
+const ids = (nodes) => nodes.map((n) => String(n.id));
+
+// ////////////////////////////////////////////////////////////////////
+describe('Comment Search', async () => {
+  let ast;
+
+  before(async () => {
+    ast = await ast_from_text(samples.FUNC + samples.STRUCT_DOC +
+      samples.EXAMPLE_1 + samples.STRUCT_MEMBERS, { search: true });
+  });
+
+  it('should find the same comments as a scan', async () => {
+    for (const query of ['nk_', 'must point', 'Return', '@', 'a', 'zzz']) {
+      expect(ids(ast.searchComments(query)).sort())
+        .to.deep.equal(scan(ast, query).sort());
+    }
+  });
+
+  it('should find combined comments once, under their first line', async () => {
+    const found = ast.searchComments('must point to');
+    expect(found.length).to.equal(1);
+    expect(Object.keys(found[0].data).length).to.be.above(5);
+    expect(ast.search.search('must point to').length).to.equal(2);
+    expect(ast.search.search('must point to')[0].id).to.equal(found[0].id);
+  });
+
+  it('should find inner comments of members', async () => {
+    const found = ast.searchComments('display name');
+    expect(found.length).to.equal(1);
+    expect(found[0].id).to.equal(`${found[0].parent}.1`);
+  });
+
+  it('should match regardless of case on request', async () => {
+    expect(ast.searchComments('PARAMETERS').length).to.equal(0);
+    expect(ast.searchComments('PARAMETERS', { ignore_case: true }).length)
+      .to.equal(1);
+  });
+
+  it('should persist the index', async () => {
+    const file = path.join(os.tmpdir(), `c-ast-search-${process.pid}.json`);
+    search.save(ast.search, file);
+
+    try {
+      const index = search.load(file);
+      for (const query of ['nk_', 'Initializes a', 'internal']) {
+        expect(index.search(query)).to.deep.equal(ast.search.search(query));
+      }
+    } finally {
+      fs.unlinkSync(file);
+    }
+  });
+});
@@ -0,0 +1,87 @@
+/**
+ * @fileOverview
+ * Tests for AST and snapshot serialization
+ *
+ * @name serializer.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_from_text = require('../lib/abstractor').ast_from_text;
+const SnapshotStore = require('../lib/snapshot').SnapshotStore;
+const serializer = require('../lib/serializer');
+const C = require('../lib/constants');
+
+/**
+ * Strings JSON.stringify escapes, or writes as is.
+ */
+const EDGES = ['"quoted"', 'back\\slash', 'tab\tnew\nline\u0001', 'naïve ✓',
+  '😀', 'lone \ud800', ''];
+
+// ////////////////////////////////////////////////////////////////////
+describe('Serializer', async () => {
+  it('should write compact json on request', async () => {
+    for (const name in samples) {
+      const ast = await ast_from_text(samples[name]);
+      const pretty = ast.json();
+
+      expect(pretty).to.equal(JSON.stringify(JSON.parse(pretty), null, '    '));
+      expect(ast.json({ compact: true }))
+        .to.equal(JSON.stringify(JSON.parse(pretty)));
+    }
+  });
+
+  it('should write snapshots as their asts in both modes', async () => {
+    for (const opts of [{}, { preprocess: true }]) {
+      for (const name in samples) {
+        const ast = await ast_from_text(samples[name], opts);
+        const snapshot = new SnapshotStore().publish(ast);
+
+        for (const compact of [false, true]) {
+          expect(snapshot.json({ compact })).to.equal(ast.json({ compact }));
+          // Again, from cached fragments
+          expect(snapshot.json({ compact })).to.equal(ast.json({ compact }));
+        }
+      }
+    }
+  });
+
+  it('should only reuse the output of unchanged nodes', async () => {
+    const ast = await ast_from_text(samples.EXAMPLE_1);
+    const store = new SnapshotStore();
+    const first = store.publish(ast);
+    const expected = [first.json(), first.json({ compact: true })];
+
+    const id = first.keys(C.CODE)[0];
+    const node = first.node(id);
+    const copy = Object.assign(Object.create(Object.getPrototypeOf(node)), node);
+    copy.data = Object.assign({}, node.data, { edges: EDGES });
+    const next = store.update((snapshot) => snapshot.set(C.CODE, id, copy));
+
+    const data = JSON.parse(expected[0]);
+    data.nodes[C.CODE][id].data.edges = EDGES;
+    expect(next.json()).to.equal(JSON.stringify(data, null, '    '));
+    expect(next.json({ compact: true })).to.equal(JSON.stringify(data));
+
+    // Readers of the first version are unaffected
+    expect(first.json()).to.equal(expected[0]);
+    expect(first.json({ compact: true })).to.equal(expected[1]);
+  });
+
+  it('should nest fragments as JSON.stringify does', async () => {
+    const values = [Object.freeze({ a: EDGES, b: { c: [] }, d: {} }),
+      { e: [1, -0.5, null, true] }, EDGES, 'text', 0];
+
+    const keys = values.map((v, i) => String(i));
+    for (const compact of [false, true]) {
+      const parts = values.map((v) => serializer.fragment(v, 1, compact));
+      expect(serializer.object(keys, parts, 0, compact))
+        .to.equal(serializer.json(Object.assign({}, values), compact));
+    }
+    expect(serializer.object([], [], 2)).to.equal('{}');
+  });
+});
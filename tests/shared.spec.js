@@ -0,0 +1,99 @@
+/**
+ * @fileOverview
+ * Tests for ASTs laid out in shared memory
+ *
+ * @name shared.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const Worker = require('worker_threads').Worker;
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const shared = require('../lib/shared');
+const ast_from_text = require('../lib/abstractor').ast_from_text;
+const C = require('../lib/constants');
+
+const CONTAINERS = [C.COMM, C.CODE, C.DEF, C.CHAR, C.SKIP];
+
+/**
+ * Reads a node out of a shared AST from a worker thread.
+ */
+function read_in_worker(sab, id) {
+  const worker = new Worker(`
+    const { parentPort, workerData } = require('worker_threads');
+    const { SharedAST } = require(${JSON.stringify(require.resolve('../lib/shared'))});
+    const ast = new SharedAST(workerData.sab);
+    parentPort.postMessage(JSON.stringify(ast.node(workerData.id)));
+  `, { eval: true, workerData: { sab, id } });
+
+  return new Promise((resolve, reject) => {
+    worker.once('message', resolve);
+    worker.once('error', reject);
+  });
+}
+
+// ////////////////////////////////////////////////////////////////////
+describe('Shared AST', async () => {
+  let ast;
+  let view;
+
+  before(async () => {
+    ast = await ast_from_text(samples.EXAMPLE_1 + samples.STRUCT_MEMBERS +
+      samples.CONDITIONALS, { preprocess: true, decl: true });
+    view = new shared.SharedAST(shared.share(ast));
+  });
+
+  it('should list the same keys', async () => {
+    for (const type of CONTAINERS) {
+      expect(view.keys(type)).to.deep.equal(ast.keys(type));
+    }
+    expect(view.keys(C.SKIP).length).to.be.above(0);
+  });
+
+  it('should decode nodes and members as generated', async () => {
+    for (const type of CONTAINERS) {
+      for (const id of ast.keys(type)) {
+        expect(JSON.stringify(view.node(id)))
+          .to.equal(JSON.stringify(ast.node(id)));
+
+        for (const member of ast.node(id).inner || []) {
+          expect(JSON.stringify(view.node(member.id)))
+            .to.equal(JSON.stringify(member));
+        }
+      }
+    }
+  });
+
+  it('should read source lines, spans and types', async () => {
+    expect(view.lines).to.equal(ast.source.length);
+    for (let lno = 0; lno < ast.source.length; lno++) {
+      expect(view.line(lno)).to.equal(ast.source[lno]);
+    }
+
+    const def = ast.keys(C.DEF)[0];
+    const lines = Object.keys(ast.node(def).data).map(Number);
+    expect(view.span(def)).to.deep.equal([Number(def), Math.max(...lines)]);
+    expect(view.types.names).to.deep.equal(ast.types.names);
+  });
+
+  it('should hand out frozen nodes', async () => {
+    const def = ast.keys(C.DEF)[0];
+    const node = view.node(def);
+
+    expect(Object.isFrozen(node)).to.equal(true);
+    expect(Object.isFrozen(node.inner)).to.equal(true);
+    expect(view.node(def)).to.equal(node);
+    expect(view.inner(def, C.MEMB).length)
+      .to.equal(ast.inner(def, C.MEMB).length);
+  });
+
+  it('should be readable from worker threads', async () => {
+    const def = ast.keys(C.DEF)[0];
+    const json = await read_in_worker(view.buffer, def);
+    expect(json).to.equal(JSON.stringify(ast.node(def)));
+  });
+});
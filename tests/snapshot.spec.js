@@ -0,0 +1,192 @@
+/**
+ * @fileOverview
+ * Tests for immutable AST snapshots
+ *
+ * @name snapshot.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const ast_gen = require('../lib/abstractor').ast_gen;
+const PersistentMap = require('../lib/hamt').PersistentMap;
+const SnapshotStore = require('../lib/snapshot').SnapshotStore;
+const NodePool = require('../lib/pool').NodePool;
+const C = require('../lib/constants');
+
+const helpers = require('./test_helper');
+const setup = helpers.setup;
+
+// ////////////////////////////////////////////////////////////////////
+describe('Persistent Map', async () => {
+  it('should leave previous versions untouched', async () => {
+    const a = PersistentMap.empty().set('1', 'one').set('2', 'two');
+    const b = a.set('2', 'deux').delete('1');
+
+    expect(a.size).to.equal(2);
+    expect(a.get('2')).to.equal('two');
+    expect(b.size).to.equal(1);
+    expect(b.get('2')).to.equal('deux');
+    expect(b.has('1')).to.equal(false);
+    expect(a.set('1', 'one')).to.equal(a);
+  });
+
+  it('should agree with a mutable map', async () => {
+    const ref = new Map();
+    let map = PersistentMap.empty();
+
+    for (let i = 0; i < 5000; i++) {
+      const key = String((i * 7919) % 1031);
+      if (i % 3 == 0) {
+        map = map.delete(key);
+        ref.delete(key);
+      } else {
+        map = map.set(key, i);
+        ref.set(key, i);
+      }
+    }
+
+    expect(map.size).to.equal(ref.size);
+    for (const [key, value] of ref) {
+      expect(map.get(key)).to.equal(value);
+    }
+    expect(Array.from(map.keys()).length).to.equal(ref.size);
+  });
+});
+
+// ////////////////////////////////////////////////////////////////////
+describe('Snapshots', async () => {
+  const EDITED = samples.STRUCT_FUNCS.replace('NK_API', 'NK_LIB');
+  let store;
+  let first;
+  let first_json;
+
+  before(async () => {
+    store = new SnapshotStore();
+    const ast = await ast_gen(setup(samples.STRUCT_FUNCS).input);
+    first_json = ast.json();
+    first = store.publish(ast);
+  });
+
+  it('should serialize like the published ast', async () => {
+    expect(first.version).to.equal(1);
+    expect(first.json()).to.equal(first_json);
+    expect(first.keys(C.COMM)).to.deep.equal(['2', '7', '12']);
+  });
+
+  it('should freeze published nodes', async () => {
+    const node = first.node(15);
+    expect(Object.isFrozen(node)).to.equal(true);
+    expect(Object.isFrozen(node.data)).to.equal(true);
+    expect(Object.isFrozen(first)).to.equal(true);
+  });
+
+  it('should share unchanged nodes with the previous version', async () => {
+    const ast = await ast_gen(setup(EDITED).input);
+    const expected = ast.json();
+    const next = store.publish(ast);
+
+    expect(next.version).to.equal(2);
+    expect(store.current).to.equal(next);
+    expect(next.json()).to.equal(expected);
+
+    let changed = 0;
+    for (const type of [C.COMM, C.CODE, C.DEF, C.CHAR]) {
+      for (const id of next.keys(type)) {
+        if (next.nodes[type].get(id) !== first.nodes[type].get(id)) {
+          changed++;
+        }
+      }
+    }
+    expect(changed).to.equal(1);
+
+    // Readers of the first version are unaffected
+    expect(first.json()).to.equal(first_json);
+  });
+
+  it('should keep shared nodes out of the pool', async () => {
+    const pool = new NodePool();
+    const ast = await ast_gen(setup(samples.STRUCT_FUNCS).input, { pool });
+    const total = ast.keys(C.COMM).length + ast.keys(C.CODE).length +
+      ast.keys(C.DEF).length + ast.keys(C.CHAR).length;
+
+    new SnapshotStore().publish(ast);
+    pool.release(ast);
+    expect(pool.stats().idle).to.equal(0);
+
+    const other = await ast_gen(setup(samples.STRUCT_FUNCS).input, { pool });
+    pool.release(other);
+    expect(pool.stats().idle).to.be.above(total - 1);
+  });
+
+  it('should update single nodes by path copying', async () => {
+    const current = store.current;
+    const next = store.update((snap) => snap.remove(C.CHAR, 0));
+
+    expect(next.version).to.equal(current.version + 1);
+    expect(next.keys(C.CHAR)).to.not.include('0');
+    expect(current.keys(C.CHAR)).to.include('0');
+    expect(next.nodes[C.COMM]).to.equal(current.nodes[C.COMM]);
+  });
+
+  it('should drop the index entries of removed nodes', async () => {
+    const current = store.current;
+    const id = current.keys(C.DEF)[0];
+    const lines = Object.keys(current.node(id).data)
+      .concat(Object.keys(current.node(id).index || {}));
+    const next = store.update((snap) => snap.remove(C.DEF, id));
+
+    for (const lno of lines) {
+      expect(current.index.get(lno)).to.not.equal(undefined);
+      expect(next.index.get(lno)).to.equal(undefined);
+    }
+    expect(next.index.size).to.equal(current.index.size - lines.length);
+    expect(store.update((snap) => snap.remove(C.DEF, id))).to.equal(next);
+  });
+
+  it('should set and remove nodes as publishing the same ast would', async () => {
+    const MEMBERS = [
+      'struct a {',
+      '  int x; // x comment',
+      '  int y; /* y comment */',
+      '};',
+      'struct b {',
+      '  int z; // z',
+      '};',
+    ];
+    const EDITED_MEMBERS = MEMBERS.slice();
+    EDITED_MEMBERS[1] = '  int w; // w comment';
+    EDITED_MEMBERS[2] = '  int y;';
+
+    const gen = (lines) => ast_gen(setup('\n' + lines.join('\n')).input);
+    const full = await gen(MEMBERS);
+    const edited = await gen(EDITED_MEMBERS);
+    const without = await gen(MEMBERS.slice(0, 4));
+    const expected = {
+      full: full.json(), edited: edited.json(), without: without.json()
+    };
+    const def = (ast, id) => ast[C.DEF][id];
+
+    const local = new SnapshotStore();
+    const first = local.publish(full);
+
+    const removed = first.remove(C.DEF, 5);
+    expect(removed.json()).to.equal(expected.without);
+    expect(removed.nodes[C.COMM].get('6.1')).to.equal(undefined);
+    expect(removed.index.get('6.1')).to.equal(undefined);
+
+    // Under an id the snapshot no longer holds
+    const restored = removed.set(C.DEF, 5, def(full, 5));
+    expect(restored.json()).to.equal(expected.full);
+    expect(restored.node(6)).to.equal(first.node(6));
+    expect(restored.node('6.1')).to.equal(first.node('6.1'));
+
+    const replaced = first.set(C.DEF, 1, def(edited, 1));
+    expect(replaced.json()).to.equal(expected.edited);
+    expect(replaced.node('3.1')).to.equal(undefined);
+    expect(replaced.node('2.1').data[2]).to.equal('// w comment');
+  });
+});
@@ -0,0 +1,119 @@
+/**
+ * @fileOverview
+ * Tests for the project wide symbol index
+ *
+ * @name symbols.spec.js
+ * @author Bailey Cosier <bailey@cosier.ca>
+ * @license MIT
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const chai = require('chai');
+const expect = chai.expect;
+
+const samples = require('./samples');
+const symbols = require('../lib/symbols');
+
+/**
+ * Rewrites a file, moving its mtime forward so the change is detected
+ * regardless of the filesystem timestamp resolution.
+ */
+function rewrite(file, text, offset = 10) {
+  fs.writeFileSync(file, text);
+  const when = new Date(Date.now() + offset * 1000);
+  fs.utimesSync(file, when, when);
+}
+
+// ////////////////////////////////////////////////////////////////////
+describe('Symbol Index', async () => {
+  let dir;
+
+  before(async () => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'c-ast-symbols-'));
+    fs.mkdirSync(path.join(dir, 'sub'));
+    fs.writeFileSync(path.join(dir, 'funcs.h'), samples.STRUCT_FUNCS);
+    fs.writeFileSync(path.join(dir, 'sub', 'enums.h'),
+      samples.ENUMS_SINGLE_LINE);
+    fs.writeFileSync(path.join(dir, 'notes.txt'), 'int ignored(void);\n');
+  });
+
+  after(async () => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('should index functions, structs and enums', async () => {
+    const stats = await symbols.build(dir);
+
+    expect(stats.files).to.equal(2);
+    expect(stats.parsed).to.equal(2);
+    expect(fs.existsSync(path.join(dir, symbols.DB_NAME))).to.equal(true);
+
+    const found = symbols.lookup('nk_convert_result', { dir });
+    expect(found.length).to.equal(1);
+    expect(found[0].kind).to.equal('enum');
+    expect(found[0].file).to.equal(path.join(dir, 'sub', 'enums.h'));
+    expect(found[0].start).to.equal(found[0].id);
+  });
+
+  it('should look names up from the names map', async () => {
+    const db = JSON.parse(
+      fs.readFileSync(path.join(dir, symbols.DB_NAME), 'utf8'));
+    const refs = db.names.nk_convert_result;
+
+    expect(refs.length).to.equal(1);
+    const [rel, i] = refs[0];
+    expect(rel).to.equal(path.join('sub', 'enums.h'));
+    expect(db.files[rel].symbols[i].name).to.equal('nk_convert_result');
+
+    expect(symbols.lookup('toString', { dir })).to.be.empty;
+    expect(symbols.lookup('__proto__', { dir })).to.be.empty;
+  });
+
+  it('should rebuild databases of an older layout', async () => {
+    const db = path.join(dir, 'old.json');
+    fs.writeFileSync(db, JSON.stringify({ version: 1, root: dir, files: {} }));
+
+    const stats = await symbols.build(dir, { db });
+    expect(stats.parsed).to.equal(2);
+    expect(symbols.lookup('nk_convert_result', { db }).length).to.equal(1);
+    fs.unlinkSync(db);
+  });
+
+  it('should only reparse changed files', async () => {
+    const stats = await symbols.build(dir);
+    expect(stats.parsed).to.equal(0);
+    expect(stats.reused).to.equal(2);
+
+    // Touched without content changes
+    const funcs = path.join(dir, 'funcs.h');
+    rewrite(funcs, samples.STRUCT_FUNCS);
+    expect((await symbols.build(dir)).parsed).to.equal(0);
+
+    rewrite(funcs, samples.STRUCT_FUNCS + '\nint added_later(void);\n', 20);
+    const changed = await symbols.build(dir);
+    expect(changed.parsed).to.equal(1);
+    expect(changed.reused).to.equal(1);
+    expect(symbols.lookup('added_later', { dir }).length).to.equal(1);
+  });
+
+  it('should forget removed files', async () => {
+    fs.unlinkSync(path.join(dir, 'sub', 'enums.h'));
+
+    const stats = await symbols.build(dir);
+    expect(stats.removed).to.equal(1);
+    expect(symbols.lookup('nk_convert_result', { dir })).to.be.empty;
+  });
+
+  it('should index long generated lines in linear time', async () => {
+    const file = path.join(dir, 'generated.h');
+    rewrite(file, `int t_${'x'.repeat(200000)} = 1;\nint after_long(void);\n`);
+
+    const start = Date.now();
+    await symbols.build(dir);
+    expect(Date.now() - start).to.be.below(2000);
+    expect(symbols.lookup('after_long', { dir }).length).to.equal(1);
+  });
+});